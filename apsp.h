@@ -0,0 +1,242 @@
+/**
+ * 多源最短路（all-pairs shortest paths, APSP）
+ * shortcut.cpp 中的 step 把 k 放在最内层：r[i][j] 更新时 r[i][k]、r[k][j] 还不是最终值，得到的并不是最短路，
+ * 而且三重循环没有任何局部性。这里实现分块 Floyd-Warshall：
+ * 矩阵补齐到 B 的倍数后按 B×B 分块，对每个 kb：
+ * 1. 阶段一：对角块 (kb, kb) 内部做普通 Floyd-Warshall
+ * 2. 阶段二：第 kb 行、第 kb 列的其余块，只依赖对角块和自身，各块之间相互独立，可并行
+ * 3. 阶段三：其余块 (ib, jb) += 列块 (ib, kb) ⊗ 行块 (kb, jb)，是一次 min-plus 乘法，
+ *    各块之间相互独立，OpenMP 并行，并沿 j 方向向量化
+ * 所有 B×B 块都只有 B*B*4 字节（B = 64 时 16KB），一次更新中用到的三个块可同时放进 L1。
+ *
+ * 另一种做法是反复做 min-plus 平方（apsp_squaring）：每个 shortcut_v*.cpp 中的 step 恰好就是一次平方，
+ * 对角线为 0 时第 m 轮之后得到的是至多 2^m 跳的最短路，因此至多 ceil(log2(n)) 轮即收敛，
+ * 且可以直接复用所有 SIMD / OpenMP 内核。
+ *
+ * 分块 Floyd-Warshall 与 dispatch.h 相同，块内运算按向量长度 L 模板化：默认 4 lane（SSE），CPU 支持时选用 target("avx2,fma") 的
+ * 8 lane 版本（即 float8_t）。块大小 B 为 16 的倍数，补齐后每行起始地址都按 64 字节对齐。
+ */
+
+#ifndef APSP_H
+#define APSP_H
+
+#pragma once
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "dispatch.h"
+
+constexpr size_t fw_block = 64;
+
+// 块 (i0, j0) 内按 Floyd-Warshall 的顺序（k 在最外层）原地更新，用于阶段一、阶段二
+template <size_t L>
+PPC_INLINE void fw_block_inplace(float *D, size_t ld, size_t i0, size_t j0, size_t k0) {
+    typedef floatv_t<L> V;
+    constexpr size_t B = fw_block;
+    for (size_t k = k0; k < k0 + B; ++k) {
+        const V *dk = reinterpret_cast<const V *>(D + ld * k + j0);
+        for (size_t i = i0; i < i0 + B; ++i) {
+            V *di = reinterpret_cast<V *>(D + ld * i + j0);
+            const V x = V{} + D[ld * i + k];
+            for (size_t v = 0; v < B / L; ++v) {
+                V z = x + dk[v];
+                di[v] = di[v] > z ? z : di[v];
+            }
+        }
+    }
+}
+
+// 块 (i0, j0) = min(块 (i0, j0), 块 (i0, k0) ⊗ 块 (k0, j0))，用于阶段三；每行 B/L 个累加器常驻寄存器
+template <size_t L>
+PPC_INLINE void fw_block_minplus(float *D, size_t ld, size_t i0, size_t j0, size_t k0) {
+    typedef floatv_t<L> V;
+    constexpr size_t B = fw_block;
+    for (size_t i = i0; i < i0 + B; ++i) {
+        V *di = reinterpret_cast<V *>(D + ld * i + j0);
+        V vv[B / L];
+        for (size_t v = 0; v < B / L; ++v)
+            vv[v] = di[v];
+        for (size_t k = k0; k < k0 + B; ++k) {
+            const V *dk = reinterpret_cast<const V *>(D + ld * k + j0);
+            const V x = V{} + D[ld * i + k];
+            for (size_t v = 0; v < B / L; ++v) {
+                V z = x + dk[v];
+                vv[v] = vv[v] > z ? z : vv[v];
+            }
+        }
+        for (size_t v = 0; v < B / L; ++v)
+            di[v] = vv[v];
+    }
+}
+
+// 分块 Floyd-Warshall 的三个阶段，D 为补齐后的 N×N 矩阵，行距为 ld
+#define PPC_FW_BODY(L)                                              \
+    for (size_t kb = 0; kb < nb; ++kb) {                            \
+        const size_t k0 = kb * B;                                   \
+        /* 阶段一：对角块 */                                        \
+        fw_block_inplace<L>(D, ld, k0, k0, k0);                      \
+        /* 阶段二：第 kb 行与第 kb 列 */                            \
+        _Pragma("omp parallel for")                                 \
+        for (size_t b = 0; b < nb; ++b) {                           \
+            if (b == kb)                                            \
+                continue;                                           \
+            fw_block_inplace<L>(D, ld, k0, b * B, k0);               \
+            fw_block_inplace<L>(D, ld, b * B, k0, k0);               \
+        }                                                           \
+        /* 阶段三：其余块 */                                        \
+        _Pragma("omp parallel for collapse(2)")                     \
+        for (size_t ib = 0; ib < nb; ++ib) {                        \
+            for (size_t jb = 0; jb < nb; ++jb) {                    \
+                if (ib == kb || jb == kb)                           \
+                    continue;                                       \
+                fw_block_minplus<L>(D, ld, ib * B, jb * B, k0);      \
+            }                                                       \
+        }                                                           \
+    }
+
+inline void fw_blocked_sse(float *D, size_t N, size_t ld) {
+    constexpr size_t B = fw_block;
+    const size_t nb = N / B;
+    PPC_FW_BODY(4)
+}
+
+#ifdef PPC_HAVE_X86_DISPATCH
+__attribute__((target("avx2,fma")))
+inline void fw_blocked_avx2(float *D, size_t N, size_t ld) {
+    constexpr size_t B = fw_block;
+    const size_t nb = N / B;
+    PPC_FW_BODY(8)
+}
+#endif
+
+// 分块 Floyd-Warshall：r 为 d 所表示的图的多源最短路，r、d 的行距均为 ld
+inline void apsp_floyd_warshall(float *r, const float *d, const size_t n, const size_t ld) {
+    constexpr size_t B = fw_block;
+    const size_t N = (n + B - 1) / B * B;
+    // N 总是 B 的倍数，行距再多补一条 cache line，每行为奇数条 cache line（见 Matrix::padded_ld）
+    const size_t LD = N + 16;
+
+    // 补齐到 B 的倍数，补出来的点与其他点均不相连
+    huge_ptr<float> buf = huge_array<float>(N * LD);
+    if (N && !buf)
+        throw std::bad_alloc();
+    float *D = buf.get();
+#pragma omp parallel for
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = 0; j < N; ++j)
+            D[LD * i + j] = i < n && j < n ? d[ld * i + j] : inf;
+
+#ifdef PPC_HAVE_X86_DISPATCH
+    if (selected_isa() >= SimdIsa::AVX2)
+        fw_blocked_avx2(D, N, LD);
+    else
+#endif
+        fw_blocked_sse(D, N, LD);
+
+#pragma omp parallel for
+    for (size_t i = 0; i < n; ++i)
+        std::copy(D + LD * i, D + LD * i + n, r + ld * i);
+}
+
+/* 反复平方求多源最短路，返回实际做了几轮平方
+ * 要求 d 的对角线为 0（Matrix 生成的矩阵均满足）。
+ * r 与一块同样大小的临时矩阵轮流作为输入、输出（double buffering），整个过程只分配一次；
+ * 某一轮的结果与输入完全相同时即已收敛，提前结束。跳数直径小的图远少于 log2(n) 轮。
+ * step 为任一 (r, d, n, ld) 形式的 min-plus 内核，默认使用 step_simd_dispatch（当前 CPU 上最快的版本）
+ * r、d 以及临时矩阵的行距均为 ld
+ */
+inline size_t apsp_squaring(float *r, const float *d, const size_t n, const size_t ld,
+                            step_fn step = step_simd_dispatch) {
+    huge_ptr<float> buf = huge_array<float>(n * ld);
+    if (n && !buf)
+        throw std::bad_alloc();
+    float *cur = r, *next = buf.get();
+    for (size_t i = 0; i < n; ++i)
+        std::memcpy(cur + ld * i, d + ld * i, n * sizeof(float));
+
+    size_t rounds = 0;
+    for (size_t hops = 1; hops + 1 < n; hops *= 2) {
+        step(next, cur, n, ld);
+        ++rounds;
+        std::swap(cur, next);
+
+        bool changed = false;
+#pragma omp parallel for reduction(||:changed)
+        for (size_t i = 0; i < n; ++i)
+            changed = changed || std::memcmp(cur + ld * i, next + ld * i, n * sizeof(float)) != 0;
+        if (!changed)
+            break;
+    }
+
+    if (cur != r)
+        for (size_t i = 0; i < n; ++i)
+            std::memcpy(r + ld * i, cur + ld * i, n * sizeof(float));
+    return rounds;
+}
+
+/* 与 apsp_squaring 相同，同时输出路由表 next：next[i][j] 为 i 到 j 的最短路上 i 之后的第一个点
+ * （i == j 时为 i，不可达时为 -1），配合 expand_path 还原完整路径。
+ * 每一轮使用 step_argmin_dispatch 在求最小值的同时得到中间点 k，
+ * 若 r[i][j] 严格变小（新路径为 i -> ... -> k -> ... -> j），则 next[i][j] = next[i][k]，否则保持不变；
+ * 因此不需要第二遍计算来恢复路径。要求边权非负（零权环可能导致 expand_path 提前截断）。
+ * r、next、d 的行距均为 ld
+ */
+inline size_t apsp_squaring_paths(float *r, int *next, const float *d, const size_t n, const size_t ld) {
+    huge_ptr<float> buf = huge_array<float>(n * ld);
+    huge_ptr<int> mid = huge_array<int>(n * ld);
+    if (n && (!buf || !mid))
+        throw std::bad_alloc();
+    float *cur = r, *nxt = buf.get();
+    int *k = mid.get();
+    for (size_t i = 0; i < n; ++i)
+        std::memcpy(cur + ld * i, d + ld * i, n * sizeof(float));
+
+#pragma omp parallel for
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+            next[ld * i + j] = i == j ? (int) i : d[ld * i + j] < inf ? (int) j : -1;
+
+    size_t rounds = 0;
+    for (size_t hops = 1; hops + 1 < n; hops *= 2) {
+        step_argmin_dispatch(nxt, k, cur, n, ld);
+        ++rounds;
+
+        bool changed = false;
+#pragma omp parallel for reduction(||:changed)
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                if (nxt[ld * i + j] < cur[ld * i + j]) {
+                    next[ld * i + j] = next[ld * i + k[ld * i + j]];
+                    changed = true;
+                }
+            }
+        }
+        std::swap(cur, nxt);
+        if (!changed)
+            break;
+    }
+
+    if (cur != r)
+        for (size_t i = 0; i < n; ++i)
+            std::memcpy(r + ld * i, cur + ld * i, n * sizeof(float));
+    return rounds;
+}
+
+// 按路由表 next（n×n，行距 ld）展开 i 到 j 的最短路（包含 i、j 两端），不可达时返回空
+inline std::vector<int> expand_path(const int *next, const size_t n, const size_t ld, int i, const int j) {
+    std::vector<int> path;
+    if (next[ld * i + j] < 0)
+        return path;
+    path.push_back(i);
+    while (i != j && path.size() <= n) {
+        i = next[ld * i + j];
+        path.push_back(i);
+    }
+    return path;
+}
+
+#endif //APSP_H
@@ -0,0 +1,709 @@
+/**
+ * 统一的 benchmark 程序：各 shortcut_v*.cpp 通过 PPC_REGISTER_KERNEL 注册内核（见 bench.h），这里按命令行选择运行
+ *     ./bench --list
+ *     ./bench --kernels='step_simd*,step_trans_tiled_omp' --sizes=1000,4000 --threads=1,4 --warmup=1 --reps=5
+ *     ./bench --kernels=step_simd_dispatch --sizes=2047,2048,2049 --ld=n --csv=out.csv
+ * 选项：
+ *   --list               列出所有内核（名字、所在源文件、当前 CPU 能否运行）
+ *   --kernels=p1,p2,...  要运行的内核，支持 shell 通配符，默认全部
+ *   --sizes=n1,n2,...    矩阵规模，默认 1000
+ *   --threads=t1,t2,...  OpenMP 线程数，0 表示默认（OMP_NUM_THREADS 或核数），默认 0
+ *   --warmup=k           每组不计时的预热次数，默认 1
+ *   --reps=k             每组计时次数，默认 5
+ *   --ld=padded|n        行距：padded 为 Matrix::padded_ld（默认），n 为不补齐
+ *   --seed=s             输入矩阵的种子，默认同 PPC_SEED（见 rng.h）
+ *   --csv=file|-         额外输出 CSV，- 为标准输出
+ *   --json=file|-        额外输出 JSON，- 为标准输出
+ *   --check              与 v0 的 step 逐位比较结果（step 为 O(n^3) 的标量版本，n 较大时很慢）
+ *   --report             每个规模结束后输出页面与 NUMA 报告（page_report / numa_report）
+ *   --counters=auto|off|threads
+ *                        硬件计数器（perf_counters.h）：auto 在可用时给出每次运行的合计（默认），threads 另外按线程输出，
+ *                        off 不读取；计数器不可用（如容器中）时只有时间
+ *   --calibrate          只做 roofline 标定（roofline.h）：对每个 --threads 输出计算峰值与 STREAM 带宽，然后退出
+ *   --roofline           先标定，再对每个内核给出算术强度、达到计算上限与带宽上限的比例
+ *   --verify             不计时，只做正确性校验（verify.h）：所选内核在各类输入（random / odd / tiny / inf / negative，
+ *                        两种行距）上与 step 逐位比较，并检查没有写到补齐部分；列出不一致的坐标，有任何不一致时返回 1。
+ *                        使用内置的规模，忽略 --sizes；对每个 --threads 各跑一遍
+ *   --workspace          内核的临时数组从一个在所有运行之间保留的 Workspace 借用（workspace.h），
+ *                        对比不加时即可看出每次分配、缺页的开销；结束时输出工作区的容量与分配次数
+ *   --prepared           每个规模的 d 包装成 PreparedMatrix（prepared.h），内核的转置 / 打包结果在预热时生成，
+ *                        计时的运行直接复用，对比不加时即可看出打包占的时间；每个规模结束时输出缓存大小与构建次数。
+ *                        与 --verify 一起使用时每个内核连续调用两次，校验第二次（使用缓存）的结果
+ *   --pack               只测打包阶段（pack.h）：对每个规模、线程数给出转置、pack_rows、pack_cols 的时间与吞吐量，
+ *                        以及逐元素转置（原来的写法）作为对照，并校验两种转置逐位相同，然后退出
+ *   --semirings          只测各半环（semiring.h：min_plus、max_plus、max_min、or_and）的分块内核：对每个规模、线程数、
+ *                        当前 CPU 支持的每个指令集版本计时，并与标量参考实现逐位比较（or_and 的输入为 0 / 1），然后退出
+ *   --argmin             只测 step_argmin_*（同时求中间点 k，dispatch.h）相对同一指令集 step_simd_* 的开销：对每个规模、线程数、
+ *                        当前 CPU 支持的每个指令集版本给出两者的中位数与比值，检查距离逐位相同、k 确实取到最小值，然后退出
+ *
+ * 每组（内核、规模、线程数）输出最小值、中位数、p95 时间，以及按中位数计算的：
+ * - GOP/s：有用运算次数 2n^3（n^3 次加法和 n^3 次取 min）除以时间
+ * - GB/s：有效带宽，按必须的访存量 2 * n^2 * 4 字节（读一遍 d、写一遍 r）计算，不含内核内部的打包与重复读取
+ * 计数器可用时在每行下面输出每次运行的平均计数与 IPC，CSV / JSON 中也有相应的列（不可用的事件为空 / null）
+ * --roofline 时另外输出一行：AI = n / 4 op/B，GOP/s 占计算峰值的比例、GB/s 占 triad 带宽的比例、
+ * 占 roof = min(峰值, AI * 带宽) 的比例，以及受哪一个上限限制；有 LLC 缺失计数时还给出按实际访存量估计的 AI
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fnmatch.h>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <omp.h>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "matrix.h"
+#include "pack.h"
+#include "prepared.h"
+#include "roofline.h"
+#include "semiring.h"
+#include "verify.h"
+
+namespace {
+    struct Options {
+        std::vector<std::string> kernels{"*"};
+        std::vector<size_t> sizes{1000};
+        std::vector<int> threads{0};
+        size_t warmup = 1, reps = 5;
+        bool padded = true;
+        uint64_t seed = random_seed();
+        std::string csv, json;
+        bool list = false, check = false, report = false;
+        bool counters = true, per_thread = false;
+        bool calibrate = false, roofline = false, verify = false, workspace = false, prepared = false, pack = false;
+        bool semirings = false, argmin = false;
+    };
+
+    struct Result {
+        const KernelInfo *kernel;
+        size_t n, ld;
+        int threads;
+        TimingStats t;
+        std::string check; // "ok" / "mismatch" / 未校验时为空
+        std::vector<PerfCounts> per_thread; // 每个线程每次运行的平均计数，计数器不可用时为空
+        PerfCounts counts;                  // per_thread 之和
+        const RooflineCalibration *cal;     // --roofline 时为该线程数下的标定结果，否则为空
+    };
+
+    std::vector<std::string> split(const std::string &s) {
+        std::vector<std::string> items;
+        std::stringstream ss(s);
+        for (std::string item; std::getline(ss, item, ',');)
+            if (!item.empty())
+                items.push_back(item);
+        return items;
+    }
+
+    template <typename T>
+    std::vector<T> split_numbers(const std::string &s) {
+        std::vector<T> values;
+        for (const std::string &item: split(s))
+            values.push_back((T) std::strtoull(item.c_str(), nullptr, 0));
+        return values;
+    }
+
+    [[noreturn]] void usage(const char *prog) {
+        std::cerr << "usage: " << prog << " [--list] [--kernels=p1,p2,...] [--sizes=n1,...] [--threads=t1,...]\n"
+                     "       [--warmup=k] [--reps=k] [--ld=padded|n] [--seed=s] [--csv=file|-] [--json=file|-]\n"
+                     "       [--check] [--report] [--counters=auto|off|threads] [--calibrate] [--roofline]\n"
+                     "       [--verify] [--workspace] [--prepared] [--pack] [--semirings] [--argmin]\n";
+        std::exit(2);
+    }
+
+    Options parse(const int argc, char **argv) {
+        Options opt;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const size_t eq = arg.find('=');
+            const std::string key = arg.substr(0, eq), value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+            if (key == "--list")
+                opt.list = true;
+            else if (key == "--check")
+                opt.check = true;
+            else if (key == "--report")
+                opt.report = true;
+            else if (key == "--calibrate")
+                opt.calibrate = true;
+            else if (key == "--roofline")
+                opt.roofline = true;
+            else if (key == "--verify")
+                opt.verify = true;
+            else if (key == "--workspace")
+                opt.workspace = true;
+            else if (key == "--prepared")
+                opt.prepared = true;
+            else if (key == "--pack")
+                opt.pack = true;
+            else if (key == "--semirings")
+                opt.semirings = true;
+            else if (key == "--argmin")
+                opt.argmin = true;
+            else if (value.empty())
+                usage(argv[0]);
+            else if (key == "--kernels")
+                opt.kernels = split(value);
+            else if (key == "--sizes")
+                opt.sizes = split_numbers<size_t>(value);
+            else if (key == "--threads")
+                opt.threads = split_numbers<int>(value);
+            else if (key == "--warmup")
+                opt.warmup = std::strtoull(value.c_str(), nullptr, 0);
+            else if (key == "--reps")
+                opt.reps = std::max<size_t>(1, std::strtoull(value.c_str(), nullptr, 0));
+            else if (key == "--ld" && (value == "padded" || value == "n"))
+                opt.padded = value == "padded";
+            else if (key == "--seed")
+                opt.seed = std::strtoull(value.c_str(), nullptr, 0);
+            else if (key == "--csv")
+                opt.csv = value;
+            else if (key == "--json")
+                opt.json = value;
+            else if (key == "--counters" && (value == "auto" || value == "off" || value == "threads")) {
+                opt.counters = value != "off";
+                opt.per_thread = value == "threads";
+            }
+            else
+                usage(argv[0]);
+        }
+        return opt;
+    }
+
+    bool selected(const KernelInfo &k, const Options &opt) {
+        for (const std::string &pattern: opt.kernels)
+            if (fnmatch(pattern.c_str(), k.name.c_str(), 0) == 0)
+                return true;
+        return false;
+    }
+
+    // 逐位比较 r 与参考结果的前 n 列
+    bool same_result(const Matrix &r, const Matrix &ref, const size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            if (std::memcmp(r.get_pdata() + r.get_ld() * i, ref.get_pdata() + ref.get_ld() * i,
+                            n * sizeof(float)) != 0)
+                return false;
+        return true;
+    }
+
+    /* --verify：每个输入只算一次参考结果，再依次运行各内核
+     * 返回不通过的（内核、线程数）组合个数
+     */
+    size_t run_verify(const std::vector<const KernelInfo *> &kernels, const KernelInfo &reference,
+                      const Options &opt, const int default_threads, Workspace *ws) {
+        const std::vector<VerifyCase> cases = verify_cases();
+        std::vector<std::vector<size_t>> failed(opt.threads.size(), std::vector<size_t>(kernels.size()));
+        for (const VerifyCase &c: cases) {
+            const size_t n = c.n;
+            Matrix d(n, 0.f, false, c.padded ? 0 : n), ref(n, 0.f, false, c.padded ? 0 : n);
+            Matrix r(n, 0.f, false, c.padded ? 0 : n);
+            const size_t ld = d.get_ld();
+            fill_verify_input(d.get_pdata(), n, ld, c.cls, opt.seed);
+            reference.fn(ref.get_pdata(), d.get_pdata(), n, ld);
+            // --prepared：第一次调用生成缓存，第二次使用缓存，校验第二次的结果
+            PreparedMatrix prep(d.get_pdata(), n, ld);
+            const int calls = opt.prepared ? 2 : 1;
+            for (size_t ti = 0; ti < opt.threads.size(); ++ti) {
+                const int threads = opt.threads[ti] > 0 ? opt.threads[ti] : default_threads;
+                omp_set_num_threads(threads);
+                for (size_t ki = 0; ki < kernels.size(); ++ki) {
+                    for (int call = 0; call < calls; ++call) {
+                        std::fill(r.get_pdata(), r.get_pdata() + n * ld, padding_sentinel());
+                        WorkspaceScope scope(ws);
+                        PreparedScope prepared(opt.prepared ? &prep : nullptr);
+                        kernels[ki]->fn(r.get_pdata(), d.get_pdata(), n, ld);
+                    }
+                    std::vector<Mismatch> first;
+                    const size_t count = compare_bitwise(r.get_pdata(), ref.get_pdata(), n, ld, first);
+                    if (count == 0)
+                        continue;
+                    ++failed[ti][ki];
+                    std::cout << "FAIL " << kernels[ki]->name << " (" << kernels[ki]->source << "), "
+                              << input_class_name(c.cls) << " n = " << n << ", ld = " << ld << ", threads = "
+                              << threads << ": " << count << " mismatches\n";
+                    for (const Mismatch &m: first)
+                        std::cout << "    (" << m.i << ", " << m.j << ")" << (m.padding ? " padding" : "")
+                                  << ": got " << m.got << ", want " << m.want << "\n";
+                }
+            }
+        }
+        omp_set_num_threads(default_threads);
+
+        size_t bad = 0;
+        std::cout << "\n" << std::left << std::setw(40) << "kernel" << std::setw(6) << "src" << std::right
+                  << std::setw(5) << "thr" << "  passed\n";
+        for (size_t ti = 0; ti < opt.threads.size(); ++ti) {
+            for (size_t ki = 0; ki < kernels.size(); ++ki) {
+                bad += failed[ti][ki] != 0;
+                std::cout << std::left << std::setw(40) << kernels[ki]->name << std::setw(6)
+                          << kernels[ki]->source << std::right << std::setw(5)
+                          << (opt.threads[ti] > 0 ? opt.threads[ti] : default_threads) << "  "
+                          << cases.size() - failed[ti][ki] << "/" << cases.size()
+                          << (failed[ti][ki] ? "  FAIL" : "") << "\n";
+            }
+        }
+        return bad;
+    }
+
+    /* --pack：打包阶段的吞吐量，按读 d 的 n×n 与写出的字节数之和计算
+     * 返回转置结果与逐元素转置不一致的规模个数
+     */
+    size_t run_pack(const Options &opt, const int default_threads) {
+        std::cout << "warmup: " << opt.warmup << ", reps: " << opt.reps << "\n"
+                  << std::left << std::setw(20) << "stage" << std::right << std::setw(7) << "n" << std::setw(5)
+                  << "thr" << std::setw(11) << "min(s)" << std::setw(11) << "median(s)" << std::setw(11)
+                  << "p95(s)" << std::setw(9) << "GB/s" << "  check\n";
+        size_t bad = 0;
+        for (const size_t n: opt.sizes) {
+            Matrix d(n, 0.f, true, opt.padded ? 0 : n, opt.seed);
+            Matrix t(n, 0.f, false, opt.padded ? 0 : n), ref(n, 0.f, false, opt.padded ? 0 : n);
+            const size_t ld = d.get_ld();
+            // 与 pack_simd 相同的 8 lane 补齐布局，行数补齐到 3 的倍数
+            const size_t width = (n + 7) / 8 * 8, stride = packed_stride((n + 7) / 8) * 8, rows = (n + 2) / 3 * 3;
+            auto packed = huge_array<float>(rows * stride);
+            const double square = (double) n * n * sizeof(float), padded = (double) rows * width * sizeof(float);
+
+            for (const int threads: opt.threads) {
+                const int thr = threads > 0 ? threads : default_threads;
+                omp_set_num_threads(thr);
+                const std::pair<const char *, std::function<void()>> stages[] = {
+                    {"transpose(scalar)", [&] {
+                        float *pt = t.get_pdata();
+                        const float *pd = d.get_pdata();
+#pragma omp parallel for schedule(static)
+                        for (size_t i = 0; i < n; ++i)
+                            for (size_t j = 0; j < n; ++j)
+                                pt[ld * i + j] = pd[ld * j + i];
+                    }},
+                    {"transpose", [&] { transpose(ref.get_pdata(), ld, d.get_pdata(), n, ld); }},
+                    {"pack_rows", [&] {
+                        pack_rows(RowLayout{packed.get(), stride}, rows, width, d.get_pdata(), n, n, ld);
+                    }},
+                    {"pack_cols", [&] {
+                        pack_cols(RowLayout{packed.get(), stride}, rows, width, d.get_pdata(), n, n, ld);
+                    }},
+                };
+                for (const auto &stage: stages) {
+                    const TimingStats ts = summarize(time_runs(stage.second, opt.warmup, opt.reps));
+                    const bool transposed = std::strncmp(stage.first, "transpose", 9) == 0;
+                    const double bytes = square + (transposed ? square : padded);
+                    std::string check;
+                    if (std::strcmp(stage.first, "transpose") == 0) {
+                        check = same_result(ref, t, n) ? "ok" : "mismatch";
+                        bad += check != "ok";
+                    }
+                    std::cout << std::left << std::setw(20) << stage.first << std::right << std::setw(7) << n
+                              << std::setw(5) << thr << std::fixed << std::setprecision(4) << std::setw(11)
+                              << ts.min << std::setw(11) << ts.median << std::setw(11) << ts.p95
+                              << std::setprecision(2) << std::setw(9) << bytes / ts.median * 1e-9 << "  " << check
+                              << "\n" << std::defaultfloat << std::setprecision(6);
+                }
+            }
+            omp_set_num_threads(default_threads);
+        }
+        return bad;
+    }
+
+    /* --semirings：半环 S 的各指令集版本，输入为随机矩阵（or_and 时按 5% 的密度取 0 / 1，对角线为 1）
+     * 返回结果与参考实现不一致的（版本、规模、线程数）组合个数
+     */
+    template <typename S>
+    size_t run_semiring(const Options &opt, const int default_threads) {
+        std::vector<std::pair<SimdIsa, step_fn>> fns{{SimdIsa::SSE, step_semiring_sse<S>}};
+#ifdef PPC_HAVE_X86_DISPATCH
+        if (detect_isa() >= SimdIsa::AVX2)
+            fns.emplace_back(SimdIsa::AVX2, step_semiring_avx2<S>);
+        if (detect_isa() >= SimdIsa::AVX512)
+            fns.emplace_back(SimdIsa::AVX512, step_semiring_avx512<S>);
+#endif
+        size_t bad = 0;
+        for (const size_t n: opt.sizes) {
+            Matrix d(n, 0.f, true, opt.padded ? 0 : n, opt.seed);
+            Matrix r(n, 0.f, false, opt.padded ? 0 : n), ref(n, 0.f, false, opt.padded ? 0 : n);
+            const size_t ld = d.get_ld();
+            if (std::is_same<S, OrAnd>::value)
+                for (size_t i = 0; i < n; ++i)
+                    for (size_t j = 0; j < n; ++j)
+                        d.get_pdata()[ld * i + j] = i == j || d.get_pdata()[ld * i + j] < 1.95f ? 1.f : 0.f;
+            step_semiring_ref<S>(ref.get_pdata(), d.get_pdata(), n, ld);
+
+            for (const int threads: opt.threads) {
+                const int thr = threads > 0 ? threads : default_threads;
+                omp_set_num_threads(thr);
+                for (const auto &f: fns) {
+                    const TimingStats ts = summarize(time_runs([&] { f.second(r.get_pdata(), d.get_pdata(), n, ld); },
+                                                               opt.warmup, opt.reps));
+                    const bool ok = same_result(r, ref, n);
+                    bad += !ok;
+                    std::cout << std::left << std::setw(10) << S::name << std::setw(8) << isa_name(f.first)
+                              << std::right << std::setw(7) << n << std::setw(5) << thr << std::fixed
+                              << std::setprecision(4) << std::setw(11) << ts.min << std::setw(11) << ts.median
+                              << std::setw(11) << ts.p95 << std::setprecision(2) << std::setw(9)
+                              << 2.0 * n * n * n / ts.median * 1e-9 << "  " << (ok ? "ok" : "mismatch") << "\n"
+                              << std::defaultfloat << std::setprecision(6);
+                }
+            }
+            omp_set_num_threads(default_threads);
+        }
+        return bad;
+    }
+
+    size_t run_semirings(const Options &opt, const int default_threads) {
+        std::cout << "warmup: " << opt.warmup << ", reps: " << opt.reps << "\n"
+                  << std::left << std::setw(10) << "semiring" << std::setw(8) << "isa" << std::right << std::setw(7)
+                  << "n" << std::setw(5) << "thr" << std::setw(11) << "min(s)" << std::setw(11) << "median(s)"
+                  << std::setw(11) << "p95(s)" << std::setw(9) << "GOP/s" << "  check\n";
+        return run_semiring<MinPlus>(opt, default_threads) + run_semiring<MaxPlus>(opt, default_threads) +
+               run_semiring<MaxMin>(opt, default_threads) + run_semiring<OrAnd>(opt, default_threads);
+    }
+
+    typedef void (*argmin_fn)(float *r, int *p, const float *d, size_t n, size_t ld);
+
+    // p 中的每个 k 都取到最小值：r[i][j] == d[i][k] + d[k][j]（加法与内核相同，逐位相等），没有路径（r 为 inf）时 k = -1
+    bool valid_argmin(const Matrix &r, const int *p, const Matrix &d, const size_t n) {
+        const float *dd = d.get_pdata();
+        const size_t ld = d.get_ld();
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                const float v = r.get_pdata()[r.get_ld() * i + j];
+                const int k = p[ld * i + j];
+                if (v == inf ? k != -1 : k < 0 || (size_t) k >= n || dd[ld * i + k] + dd[ld * k + j] != v)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    /* --argmin：各指令集版本的 step_argmin_* 与同一版本的 step_simd_*，输入为随机矩阵
+     * ratio 为两者中位数之比；返回距离不一致或 k 不正确的（版本、规模、线程数）组合个数
+     */
+    size_t run_argmin(const Options &opt, const int default_threads) {
+        struct Fns {
+            SimdIsa isa;
+            step_fn plain;
+            argmin_fn argmin;
+        };
+        std::vector<Fns> fns{{SimdIsa::SSE, step_simd_sse, step_argmin_sse}};
+#ifdef PPC_HAVE_X86_DISPATCH
+        if (detect_isa() >= SimdIsa::AVX2)
+            fns.push_back({SimdIsa::AVX2, step_simd_avx2, step_argmin_avx2});
+        if (detect_isa() >= SimdIsa::AVX512)
+            fns.push_back({SimdIsa::AVX512, step_simd_avx512, step_argmin_avx512});
+#endif
+        std::cout << "warmup: " << opt.warmup << ", reps: " << opt.reps << "\n"
+                  << std::left << std::setw(8) << "isa" << std::right << std::setw(7) << "n" << std::setw(5) << "thr"
+                  << std::setw(11) << "plain(s)" << std::setw(11) << "argmin(s)" << std::setw(8) << "ratio"
+                  << "  check\n";
+        size_t bad = 0;
+        for (const size_t n: opt.sizes) {
+            Matrix d(n, 0.f, true, opt.padded ? 0 : n, opt.seed);
+            Matrix r(n, 0.f, false, opt.padded ? 0 : n), ref(n, 0.f, false, opt.padded ? 0 : n);
+            const size_t ld = d.get_ld();
+            std::vector<int> p(n * ld);
+
+            for (const int threads: opt.threads) {
+                const int thr = threads > 0 ? threads : default_threads;
+                omp_set_num_threads(thr);
+                for (const Fns &f: fns) {
+                    const TimingStats tp = summarize(
+                        time_runs([&] { f.plain(ref.get_pdata(), d.get_pdata(), n, ld); }, opt.warmup, opt.reps));
+                    const TimingStats ta = summarize(time_runs(
+                        [&] { f.argmin(r.get_pdata(), p.data(), d.get_pdata(), n, ld); }, opt.warmup, opt.reps));
+                    const char *check = !same_result(r, ref, n) ? "mismatch"
+                                        : !valid_argmin(r, p.data(), d, n) ? "bad k" : "ok";
+                    bad += std::strcmp(check, "ok") != 0;
+                    std::cout << std::left << std::setw(8) << isa_name(f.isa) << std::right << std::setw(7) << n
+                              << std::setw(5) << thr << std::fixed << std::setprecision(4) << std::setw(11)
+                              << tp.median << std::setw(11) << ta.median << std::setprecision(2) << std::setw(8)
+                              << ta.median / tp.median << "  " << check << "\n"
+                              << std::defaultfloat << std::setprecision(6);
+                }
+            }
+            omp_set_num_threads(default_threads);
+        }
+        return bad;
+    }
+
+    double gops(const Result &res) {
+        return 2.0 * res.n * res.n * res.n / res.t.median * 1e-9;
+    }
+
+    double gbps(const Result &res) {
+        return 2.0 * res.n * res.n * sizeof(float) / res.t.median * 1e-9;
+    }
+
+    // 有用运算次数 / 必须的访存量
+    double intensity(const Result &res) {
+        return res.n / 4.0;
+    }
+
+    // 按 LLC 缺失估计的实际算术强度，没有计数时为 0
+    double measured_intensity(const Result &res) {
+        if (!res.counts.valid[PerfLlcMisses] || res.counts.value[PerfLlcMisses] <= 0)
+            return 0;
+        return 2.0 * res.n * res.n * res.n / (res.counts.value[PerfLlcMisses] * 64);
+    }
+
+    void print_roofline(std::ostream &os, const Result &res) {
+        const RooflineCalibration &cal = *res.cal;
+        const double ai = intensity(res), roof = cal.roof(ai);
+        os << std::fixed << std::setprecision(1) << "    roofline: AI " << ai << " op/B, "
+           << 100 * gops(res) / cal.peak_gops << "% of peak, " << 100 * gbps(res) / cal.bandwidth()
+           << "% of bandwidth, " << 100 * gops(res) / roof << "% of roof " << roof << " GOP/s ("
+           << (ai * cal.bandwidth() < cal.peak_gops ? "memory" : "compute") << "-bound)";
+        if (measured_intensity(res) > 0)
+            os << ", measured AI " << measured_intensity(res) << " op/B";
+        os << "\n" << std::defaultfloat << std::setprecision(6);
+    }
+
+    // 输出到文件或标准输出（"-"）
+    void write_to(const std::string &path, const std::string &text) {
+        if (path == "-") {
+            std::cout << text;
+            return;
+        }
+        std::ofstream out(path);
+        if (!out || !(out << text))
+            std::cerr << "cannot write " << path << "\n";
+    }
+
+    std::string to_csv(const std::vector<Result> &results) {
+        std::ostringstream os;
+        os << std::setprecision(9);
+        os << "kernel,source,n,ld,threads,runs,min_s,median_s,p95_s,mean_s,gops,gbps,check";
+        for (size_t e = 0; e < PerfEventCount; ++e)
+            os << ',' << perf_event_name(e);
+        os << ",ipc,ai,peak_gops,bandwidth_gbps,peak_frac,bandwidth_frac,roof_frac\n";
+        for (const Result &res: results) {
+            os << '"' << res.kernel->name << "\"," << res.kernel->source << ',' << res.n << ',' << res.ld << ','
+               << res.threads << ',' << res.t.runs << ',' << res.t.min << ',' << res.t.median << ','
+               << res.t.p95 << ',' << res.t.mean << ',' << gops(res) << ',' << gbps(res) << ',' << res.check;
+            for (size_t e = 0; e < PerfEventCount; ++e) {
+                os << ',';
+                if (res.counts.valid[e])
+                    os << res.counts.value[e];
+            }
+            os << ',';
+            if (res.counts.ipc() > 0)
+                os << res.counts.ipc();
+            if (res.cal)
+                os << ',' << intensity(res) << ',' << res.cal->peak_gops << ',' << res.cal->bandwidth() << ','
+                   << gops(res) / res.cal->peak_gops << ',' << gbps(res) / res.cal->bandwidth() << ','
+                   << gops(res) / res.cal->roof(intensity(res));
+            else
+                os << ",,,,,,";
+            os << '\n';
+        }
+        return os.str();
+    }
+
+    // {"cycles": ..., "instructions": ..., "ipc": ...}，不可用的事件为 null
+    void json_counts(std::ostream &os, const PerfCounts &c) {
+        os << '{';
+        for (size_t e = 0; e < PerfEventCount; ++e) {
+            os << '"' << perf_event_name(e) << "\": ";
+            if (c.valid[e])
+                os << c.value[e];
+            else
+                os << "null";
+            os << ", ";
+        }
+        os << "\"ipc\": ";
+        if (c.ipc() > 0)
+            os << c.ipc();
+        else
+            os << "null";
+        os << '}';
+    }
+
+    std::string to_json(const std::vector<Result> &results) {
+        std::ostringstream os;
+        os << std::setprecision(9);
+        os << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result &res = results[i];
+            os << "  {\"kernel\": \"" << res.kernel->name << "\", \"source\": \"" << res.kernel->source
+               << "\", \"n\": " << res.n << ", \"ld\": " << res.ld << ", \"threads\": " << res.threads
+               << ", \"runs\": " << res.t.runs << ", \"min_s\": " << res.t.min << ", \"median_s\": "
+               << res.t.median << ", \"p95_s\": " << res.t.p95 << ", \"mean_s\": " << res.t.mean
+               << ", \"gops\": " << gops(res) << ", \"gbps\": " << gbps(res) << ", \"check\": ";
+            if (res.check.empty())
+                os << "null";
+            else
+                os << '"' << res.check << '"';
+            if (!res.per_thread.empty()) {
+                os << ", \"counters\": ";
+                json_counts(os, res.counts);
+                os << ", \"per_thread\": [";
+                for (size_t t = 0; t < res.per_thread.size(); ++t) {
+                    os << (t ? ", " : "");
+                    json_counts(os, res.per_thread[t]);
+                }
+                os << ']';
+            }
+            if (res.cal)
+                os << ", \"roofline\": {\"ai\": " << intensity(res) << ", \"peak_gops\": " << res.cal->peak_gops
+                   << ", \"bandwidth_gbps\": " << res.cal->bandwidth() << ", \"peak_frac\": "
+                   << gops(res) / res.cal->peak_gops << ", \"bandwidth_frac\": " << gbps(res) / res.cal->bandwidth()
+                   << ", \"roof_frac\": " << gops(res) / res.cal->roof(intensity(res)) << '}';
+            os << (i + 1 < results.size() ? "},\n" : "}\n");
+        }
+        os << "]\n";
+        return os.str();
+    }
+}
+
+int main(int argc, char **argv) {
+    const Options opt = parse(argc, argv);
+    numa_pin_threads();
+
+    const int default_threads = omp_get_max_threads();
+    if (opt.calibrate) {
+        for (const int threads: opt.threads) {
+            omp_set_num_threads(threads > 0 ? threads : default_threads);
+            print_calibration(calibrate_roofline());
+        }
+        return 0;
+    }
+
+    if (opt.pack)
+        return run_pack(opt, default_threads) == 0 ? 0 : 1;
+    if (opt.semirings)
+        return run_semirings(opt, default_threads) == 0 ? 0 : 1;
+    if (opt.argmin)
+        return run_argmin(opt, default_threads) == 0 ? 0 : 1;
+
+    if (opt.list) {
+        for (const KernelInfo &k: kernel_registry())
+            std::cout << std::left << std::setw(40) << k.name << std::setw(6) << k.source
+                      << (k.available() ? "" : "  (not supported by this CPU)") << "\n";
+        return 0;
+    }
+
+    std::vector<const KernelInfo *> kernels;
+    for (const KernelInfo &k: kernel_registry()) {
+        if (!selected(k, opt))
+            continue;
+        if (k.available())
+            kernels.push_back(&k);
+        else
+            std::cerr << "skip " << k.name << ": not supported by this CPU\n";
+    }
+    if (kernels.empty()) {
+        std::cerr << "no kernel matches, see --list\n";
+        return 1;
+    }
+    const KernelInfo *reference = find_kernel("step");
+    if ((opt.check || opt.verify) && !reference) {
+        std::cerr << "--check / --verify need the reference kernel \"step\"\n";
+        return 1;
+    }
+    // --workspace 时所有内核、所有运行共用一个工作区
+    Workspace workspace;
+    Workspace *ws = opt.workspace ? &workspace : nullptr;
+    if (opt.verify)
+        return run_verify(kernels, *reference, opt, default_threads, ws) == 0 ? 0 : 1;
+
+    std::cout << "isa: " << isa_name(selected_isa()) << ", warmup: " << opt.warmup << ", reps: " << opt.reps
+              << ", seed: 0x" << std::hex << opt.seed << std::dec << "\n";
+    if (opt.counters && !PerfCounters(1).available())
+        std::cout << "hardware counters unavailable (no PMU, perf_event_paranoid or PPC_PERF=off), wall time only\n";
+    // 各线程数下的标定结果，在计时之前先测好
+    std::map<int, RooflineCalibration> calibrations;
+    for (const int threads: opt.threads) {
+        const int t = threads > 0 ? threads : default_threads;
+        if (!opt.roofline || calibrations.count(t))
+            continue;
+        omp_set_num_threads(t);
+        calibrations[t] = calibrate_roofline();
+        print_calibration(calibrations[t]);
+    }
+    omp_set_num_threads(default_threads);
+    std::cout << std::left << std::setw(40) << "kernel" << std::setw(6) << "src" << std::right
+              << std::setw(7) << "n" << std::setw(5) << "thr" << std::setw(11) << "min(s)"
+              << std::setw(11) << "median(s)" << std::setw(11) << "p95(s)" << std::setw(9) << "GOP/s"
+              << std::setw(9) << "GB/s" << "  check\n";
+
+    std::vector<Result> results;
+    bool all_ok = true;
+    for (const size_t n: opt.sizes) {
+        Matrix d(n, 0.f, true, opt.padded ? 0 : n, opt.seed);
+        Matrix r(n, 0.f, false, opt.padded ? 0 : n);
+        Matrix ref(opt.check ? n : 1, 0.f, false, opt.padded ? 0 : n);
+        if (opt.check)
+            reference->fn(ref.get_pdata(), d.get_pdata(), n, d.get_ld());
+        // --prepared 时同一规模的所有内核、所有线程数共用一个 PreparedMatrix（d 在此期间不变）
+        PreparedMatrix prep(d.get_pdata(), n, d.get_ld());
+        PreparedMatrix *pm = opt.prepared ? &prep : nullptr;
+
+        for (const int threads: opt.threads) {
+            omp_set_num_threads(threads > 0 ? threads : default_threads);
+            std::unique_ptr<PerfCounters> pc;
+            if (opt.counters)
+                pc.reset(new PerfCounters(threads > 0 ? threads : default_threads));
+            const RooflineCalibration *cal = nullptr;
+            if (opt.roofline)
+                cal = &calibrations[threads > 0 ? threads : default_threads];
+            for (const KernelInfo *k: kernels) {
+                Result res{k, n, d.get_ld(), threads > 0 ? threads : default_threads, {}, "", {}, {}, cal};
+                res.t = summarize(time_runs([&] {
+                                                WorkspaceScope scope(ws);
+                                                PreparedScope prepared(pm);
+                                                k->fn(r.get_pdata(), d.get_pdata(), n, d.get_ld());
+                                            },
+                                            opt.warmup, opt.reps, pc.get(), &res.per_thread));
+                for (const PerfCounts &c: res.per_thread)
+                    res.counts += c;
+                if (opt.check) {
+                    res.check = same_result(r, ref, n) ? "ok" : "mismatch";
+                    all_ok = all_ok && res.check == "ok";
+                }
+                std::cout << std::left << std::setw(40) << k->name << std::setw(6) << k->source << std::right
+                          << std::setw(7) << n << std::setw(5) << res.threads << std::fixed
+                          << std::setprecision(4) << std::setw(11) << res.t.min << std::setw(11) << res.t.median
+                          << std::setw(11) << res.t.p95 << std::setprecision(2) << std::setw(9) << gops(res)
+                          << std::setw(9) << gbps(res) << "  " << res.check << "\n"
+                          << std::defaultfloat << std::setprecision(6);
+                if (!res.per_thread.empty()) {
+                    std::cout << "    ";
+                    print_perf_counts(std::cout, res.counts);
+                    std::cout << "\n";
+                }
+                if (res.cal)
+                    print_roofline(std::cout, res);
+                for (size_t t = 0; opt.per_thread && t < res.per_thread.size(); ++t) {
+                    std::cout << "    thread " << t << ": ";
+                    print_perf_counts(std::cout, res.per_thread[t]);
+                    std::cout << "\n";
+                }
+                results.push_back(res);
+            }
+        }
+        omp_set_num_threads(default_threads);
+        if (pm)
+            std::cout << "prepared: n = " << n << ", cached " << (pm->cached_bytes() >> 20) << " MB, "
+                      << pm->builds() << " builds\n";
+
+        if (opt.report) {
+            page_report();
+            numa_report("d", d.get_pdata(), n, d.get_ld() * sizeof(float));
+        }
+    }
+
+    if (!opt.csv.empty())
+        write_to(opt.csv, to_csv(results));
+    if (!opt.json.empty())
+        write_to(opt.json, to_json(results));
+    if (ws)
+        std::cout << "workspace: capacity " << (ws->capacity() >> 20) << " MB, peak " << (ws->peak_bytes() >> 20)
+                  << " MB, " << ws->allocations() << " allocations\n";
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+/**
+ * 计时统计，供 bench.cpp 使用；内核注册表见 kernel_registry.h
+ * 计时：每个内核先运行 warmup 次（不计时，用于预热缓存、触发大页分配和首次分派），再计时 reps 次，
+ * 给出最小值、中位数、p95 和均值；单次计时受调度和频率变化影响很大，比较不同版本时以中位数为准。
+ * 硬件计数器（perf_counters.h）可用时同时给出每次运行的平均计数，按线程分开；计数器的开关不计入时间。
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "dispatch.h"
+#include "kernel_registry.h"
+#include "perf_counters.h"
+
+struct TimingStats {
+    size_t runs = 0;
+    double min = 0, median = 0, p95 = 0, mean = 0;
+};
+
+// 按最近秩（nearest rank）取分位数
+inline TimingStats summarize(std::vector<double> seconds) {
+    TimingStats s;
+    s.runs = seconds.size();
+    if (seconds.empty())
+        return s;
+    std::sort(seconds.begin(), seconds.end());
+    auto rank = [&](double q) {
+        size_t k = (size_t) std::ceil(q * seconds.size());
+        return seconds[std::min(std::max<size_t>(k, 1), seconds.size()) - 1];
+    };
+    s.min = seconds.front();
+    s.median = seconds.size() % 2 ? seconds[seconds.size() / 2]
+                                  : (seconds[seconds.size() / 2 - 1] + seconds[seconds.size() / 2]) / 2;
+    s.p95 = rank(0.95);
+    for (double t: seconds)
+        s.mean += t;
+    s.mean /= seconds.size();
+    return s;
+}
+
+/* 运行 warmup 次后计时 reps 次，返回每次的秒数
+ * pc 非空且可用时每次运行前后读取计数器，per_thread 中为各线程在 reps 次运行中的平均计数
+ */
+template <typename F>
+inline std::vector<double> time_runs(F &&f, const size_t warmup, const size_t reps, PerfCounters *pc = nullptr,
+                                     std::vector<PerfCounts> *per_thread = nullptr) {
+    for (size_t i = 0; i < warmup; ++i)
+        f();
+    const bool counting = pc && pc->available();
+    if (per_thread)
+        per_thread->assign(counting ? pc->threads() : 0, PerfCounts{});
+    std::vector<double> seconds;
+    for (size_t i = 0; i < reps; ++i) {
+        if (counting)
+            pc->start();
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        if (counting)
+            pc->stop();
+        seconds.push_back(elapsed.count());
+        if (counting && per_thread)
+            for (size_t t = 0; t < per_thread->size(); ++t)
+                (*per_thread)[t] += pc->per_thread()[t];
+    }
+    if (per_thread)
+        for (PerfCounts &c: *per_thread)
+            c /= (double) std::max<size_t>(reps, 1);
+    return seconds;
+}
+
+#endif //BENCH_H
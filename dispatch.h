@@ -0,0 +1,587 @@
+/**
+ * 运行时指令集分派（runtime ISA dispatch）
+ * float8_t 固定为 8 个 lane，生成什么指令完全取决于编译时的 -march，同一个二进制无法在不同机器上都跑到最快。
+ * 这里把 v5 的分块内核按向量长度 L 模板化，并在同一个二进制中编译出三个版本：
+ * - sse:    4 lane，x86-64 基线指令集，任何机器都可运行
+ * - avx2:   8 lane，__attribute__((target("avx2,fma")))
+ * - avx512: 16 lane，__attribute__((target("avx512f")))，实际分派到不需要补齐的 step_avx512_masked
+ * 分块内核同时按半环 S 模板化（semiring.h）：step_semiring_sse / avx2 / avx512<S> 与 step_semiring_dispatch<S>，
+ * step_simd_sse / avx2 / avx512 即 S = MinPlus 的实例。
+ * 第一次调用 step_simd_dispatch 时用 cpuid（__builtin_cpu_supports）选出可用的最高级别；
+ * 环境变量 PPC_ISA=sse|avx2|avx512 可强制指定（用于 A/B 测试），若当前 CPU 不支持则忽略并给出提示。
+ *
+ * 注意：GCC 在 OpenMP 展开（outlining）时，并行区域继承的是“所在函数”的 target 属性，
+ * 因此 #pragma omp 必须直接写在带 target 属性的函数中，循环体则放在 always_inline 的模板函数里。
+ */
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#pragma once
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <omp.h>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "hugepage.h"
+#include "pack.h"
+#include "prepared.h"
+#include "semiring.h"
+#include "simd.h"
+#include "workspace.h"
+
+// 16 lane 的向量在未开启 AVX-512 的函数中按值传递会触发 ABI 提示，这里的模板只会内联进对应 target 的函数
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define PPC_INLINE __attribute__((always_inline)) inline
+
+enum class SimdIsa { SSE, AVX2, AVX512 };
+
+inline const char *isa_name(SimdIsa isa) {
+    switch (isa) {
+        case SimdIsa::AVX512: return "avx512";
+        case SimdIsa::AVX2: return "avx2";
+        default: return "sse";
+    }
+}
+
+// 水平最小值：蝶形 shuffle，log2(L) 步后每个 lane 都是 L 个 lane 中的最小值（T 为 float 或 int 向量）
+template <size_t L, typename T, size_t W = L / 2>
+PPC_INLINE T lanes_min(T v) {
+    if constexpr (W == 0) {
+        return v;
+    } else {
+        intv_t<L> mask;
+        for (size_t l = 0; l < L; ++l)
+            mask[l] = (int) (l ^ W);
+        const T u = __builtin_shuffle(v, mask);
+        return lanes_min<L, T, W / 2>(v < u ? v : u);
+    }
+}
+
+/* 与 v5 相同的分块方案，向量长度为 L：
+ * vd / vt 的行数补齐到 3 的倍数，每行 blocks 个向量（行距 vs = packed_stride<L>(blocks)）；输出按 mc×nc 分块，k 方向每次 kc 个向量
+ * 方阵：d、r 为 n×n、行距为 ld 的矩阵，pack 填充 vd、vt（pack.h 中的分块转置）
+ * 长方形（外存版本按面板计算时使用）：r 为 m×q、行距为 ld，r[i][j] = min_k a[i][k] + b[j][k]（k < n），
+ * pack_a / pack_b 分别从 a 的行、b 的行（即已转置的右矩阵）填充 vd、vt
+ */
+template <size_t L, typename S = MinPlus>
+struct SimdPlan {
+    typedef floatv_t<L> V;
+    typedef intv_t<L> I;
+    static constexpr size_t R = 3, C = 3;
+    static constexpr size_t kc = 1024 / L;  // 每段 k 固定为 1024 个 float
+    static constexpr size_t mc = 32, nc = 32;  // 以 3 行一组计
+    static constexpr size_t ks = 8;  // run_tile_argmin 每 ks 步存一份快照
+
+    /* 每个线程的临时数组（以 float 计，按 cache line 对齐），由调用者在并行区域外用 scratch_array 一次分配，
+     * 不放在 OpenMP 工作线程的栈上：
+     * - run_tile：part（mc×nc 个输出块的部分结果）
+     * - run_tile_argmin：part、pidx 与快照
+     */
+    static constexpr size_t part_size = mc * R * nc * C;
+    static constexpr size_t tile_scratch = (part_size + 15) / 16 * 16;
+    static constexpr size_t argmin_scratch = (2 * part_size + (kc + ks - 1) / ks * R * C * L + 15) / 16 * 16;
+
+    size_t n, m, q, ld, blocks, vs, na, nb, mt, nt;
+    PackedOperand packed;
+    float *pd, *pt;
+
+    // 方阵：d 不变时 vd、vt 可以留在当前的 PreparedMatrix 中（见 prepared.h），needs_pack() 为假时不必再打包
+    SimdPlan(const float *d, size_t n, size_t ld) : SimdPlan(key().c_str(), d, n, n, n, ld) {}
+
+    // 长方形：a、b 每次都不同，不缓存
+    SimdPlan(size_t m, size_t q, size_t n, size_t ld) : SimdPlan(nullptr, nullptr, m, q, n, ld) {}
+
+    // key 为空时 vd、vt 同 scratch_array，每次都要打包
+    SimdPlan(const char *key, const float *d, size_t m, size_t q, size_t n, size_t ld)
+        : n(n), m(m), q(q), ld(ld), blocks((n + L - 1) / L), vs(packed_stride<L>(blocks)),
+          na((m + R - 1) / R), nb((q + C - 1) / C), mt((na + mc - 1) / mc), nt((nb + nc - 1) / nc),
+          packed(key, d, n, ld, na * R * vs * L * sizeof(float), nb * C * vs * L * sizeof(float)),
+          pd(packed.get<float>(0)), pt(packed.get<float>(1)) {}
+
+    // 补齐值随半环不同，布局也就不同
+    static std::string key() {
+        return "simd_plan/" + std::to_string(L) + "/" + S::name;
+    }
+
+    bool needs_pack() const { return packed.needs_build(); }
+
+    void pack_done() { packed.built(); }
+
+    V *vd() const { return reinterpret_cast<V *>(pd); }
+
+    V *vt() const { return reinterpret_cast<V *>(pt); }
+
+    size_t rows() const { return na * R; }
+
+    size_t cols() const { return nb * C; }
+
+    size_t tiles() const { return mt * nt; }
+
+    // 填充 vd（d 的各行）、vt（d 的各列），越界部分为 S::zero；各自带并行区域，不需要在 target 函数中展开
+    void pack(const float *d) {
+        pack_rows(RowLayout{pd, vs * L}, rows(), blocks * L, d, n, n, ld, S::zero);
+        pack_cols(RowLayout{pt, vs * L}, cols(), blocks * L, d, n, n, ld, S::zero);
+    }
+
+    // 填充 vd：a 的各行（m×n，行距 lda）
+    void pack_a(const float *a, size_t lda) {
+        pack_rows(RowLayout{pd, vs * L}, rows(), blocks * L, a, m, n, lda, S::zero);
+    }
+
+    // 填充 vt：b 的各行（q×n，行距 ldb）
+    void pack_b(const float *b, size_t ldb) {
+        pack_rows(RowLayout{pt, vs * L}, cols(), blocks * L, b, q, n, ldb, S::zero);
+    }
+
+    // 计算第 t 个输出块：⊗ 为 S::combine，⊕ 为 S::reduce（min-plus 时即 x + y 与 min）
+    PPC_INLINE void run_tile(float *r, size_t t, float *part) const {
+        const size_t jt = t / mt, it = t % mt;
+        const size_t ic0 = it * mc, ic1 = std::min(ic0 + mc, na);
+        const size_t jc0 = jt * nc, jc1 = std::min(jc0 + nc, nb);
+        const size_t ldp = (jc1 - jc0) * C;
+        std::fill(part, part + (ic1 - ic0) * R * ldp, S::zero);
+
+        for (size_t k0 = 0; k0 < blocks; k0 += kc) {
+            const size_t k1 = std::min(k0 + kc, blocks);
+            for (size_t ic = ic0; ic < ic1; ++ic) {
+                const V *x0 = vd() + (ic * R) * vs;
+                for (size_t jc = jc0; jc < jc1; ++jc) {
+                    const V *y0 = vt() + (jc * C) * vs;
+                    V vv[R][C];
+                    for (size_t a = 0; a < R; ++a)
+                        for (size_t b = 0; b < C; ++b)
+                            vv[a][b] = V{} + S::zero;
+
+                    for (size_t k = k0; k < k1; ++k) {
+                        V x[R], y[C];
+                        for (size_t a = 0; a < R; ++a)
+                            x[a] = x0[a * vs + k];
+                        for (size_t b = 0; b < C; ++b)
+                            y[b] = y0[b * vs + k];
+                        for (size_t a = 0; a < R; ++a)
+                            for (size_t b = 0; b < C; ++b)
+                                vv[a][b] = S::reduce(vv[a][b], S::combine(x[a], y[b]));
+                    }
+
+                    for (size_t a = 0; a < R; ++a) {
+                        for (size_t b = 0; b < C; ++b) {
+                            float &p = part[((ic - ic0) * R + a) * ldp + (jc - jc0) * C + b];
+                            for (size_t l = 0; l < L; ++l)
+                                p = S::reduce(p, vv[a][b][l]);
+                        }
+                    }
+                }
+            }
+        }
+
+        for (size_t ii = 0; ii < (ic1 - ic0) * R && ic0 * R + ii < m; ++ii)
+            for (size_t jj = 0; jj < ldp && jc0 * C + jj < q; ++jj)
+                r[ld * (ic0 * R + ii) + jc0 * C + jj] = part[ii * ldp + jj];
+    }
+
+    /* 与 run_tile 相同（只用于 min-plus），同时把取得最小值的 k 写入 p（没有路径时为 -1）
+     * 内层循环与 run_tile 完全相同，不跟踪下标；每 ks 步把 9 个累加器存一份快照 snap（每个 k 分段 kc / ks 份，在 L1 中）。
+     * 每个 k 分段结束时，若这个 3×3 块中有输出的最小值 best 变小了，就对 9 个输出同时（互不依赖，没有依赖数据的分支）确定 k：
+     * 1. 取到 best 的 lane 中编号最小的一个 l
+     * 2. 快照单调不增，lane l 上仍大于 best 的快照个数就是 best 第一次出现的小段
+     * 3. 在这一小段内重新计算 ks 个和，第一个等于 best 的即为 k（同样的加法，结果逐位相同；x、y 刚读过，仍在 L1 中）
+     * 因此下标的开销是每个 k 分段一次，而不是每一步。多个 k 取到同一最小值时结果为其中之一（同一 ISA 下是确定的）。
+     */
+    PPC_INLINE void run_tile_argmin(float *r, int *p, size_t t, float *scratch) const {
+        const size_t jt = t / mt, it = t % mt;
+        const size_t ic0 = it * mc, ic1 = std::min(ic0 + mc, na);
+        const size_t jc0 = jt * nc, jc1 = std::min(jc0 + nc, nb);
+        const size_t ldp = (jc1 - jc0) * C;
+        float *part = scratch;
+        int *pidx = reinterpret_cast<int *>(scratch + part_size);
+        V *snap = reinterpret_cast<V *>(scratch + 2 * part_size);
+        std::fill(part, part + (ic1 - ic0) * R * ldp, inf);
+        I lane;
+        for (size_t l = 0; l < L; ++l)
+            lane[l] = (int) l;
+
+        for (size_t k0 = 0; k0 < blocks; k0 += kc) {
+            const size_t k1 = std::min(k0 + kc, blocks);
+            const size_t subs = (k1 - k0 + ks - 1) / ks;
+            for (size_t ic = ic0; ic < ic1; ++ic) {
+                const V *x0 = vd() + (ic * R) * vs;
+                for (size_t jc = jc0; jc < jc1; ++jc) {
+                    const V *y0 = vt() + (jc * C) * vs;
+                    V vv[R][C];
+                    for (size_t a = 0; a < R; ++a)
+                        for (size_t b = 0; b < C; ++b)
+                            vv[a][b] = V{} + inf;
+
+                    for (size_t u = 0; u < subs; ++u) {
+                        const size_t s1 = std::min(k0 + (u + 1) * ks, k1);
+                        for (size_t k = k0 + u * ks; k < s1; ++k) {
+                            V x[R], y[C];
+                            for (size_t a = 0; a < R; ++a)
+                                x[a] = x0[a * vs + k];
+                            for (size_t b = 0; b < C; ++b)
+                                y[b] = y0[b * vs + k];
+                            for (size_t a = 0; a < R; ++a) {
+                                for (size_t b = 0; b < C; ++b) {
+                                    V z = x[a] + y[b];
+                                    vv[a][b] = vv[a][b] > z ? z : vv[a][b];
+                                }
+                            }
+                        }
+                        for (size_t a = 0; a < R; ++a)
+                            for (size_t b = 0; b < C; ++b)
+                                snap[(u * R + a) * C + b] = vv[a][b];
+                    }
+
+                    // best 广播到所有 lane
+                    V best[R][C];
+                    bool any = false;
+                    for (size_t a = 0; a < R; ++a) {
+                        for (size_t b = 0; b < C; ++b) {
+                            best[a][b] = lanes_min<L>(vv[a][b]);
+                            any |= best[a][b][0] < part[((ic - ic0) * R + a) * ldp + (jc - jc0) * C + b];
+                        }
+                    }
+                    if (!any)
+                        continue;
+
+                    I li[R][C], pos[R][C];
+                    size_t kv[R][C];
+                    for (size_t a = 0; a < R; ++a) {
+                        for (size_t b = 0; b < C; ++b) {
+                            li[a][b] = lanes_min<L>(vv[a][b] == best[a][b] ? lane : I{} + (int) L);
+                            I cnt = I{};
+                            for (size_t u = 0; u < subs; ++u)
+                                cnt -= snap[(u * R + a) * C + b] > best[a][b];
+                            kv[a][b] = k0 + (size_t) __builtin_shuffle(cnt, li[a][b])[0] * ks;
+                            pos[a][b] = I{};
+                        }
+                    }
+                    for (size_t s = ks; s-- > 0;) {
+                        for (size_t a = 0; a < R; ++a) {
+                            for (size_t b = 0; b < C; ++b) {
+                                const size_t k = std::min(kv[a][b] + s, k1 - 1);
+                                pos[a][b] = x0[a * vs + k] + y0[b * vs + k] == best[a][b] ? I{} + (int) s : pos[a][b];
+                            }
+                        }
+                    }
+                    for (size_t a = 0; a < R; ++a) {
+                        for (size_t b = 0; b < C; ++b) {
+                            const size_t q = ((ic - ic0) * R + a) * ldp + (jc - jc0) * C + b;
+                            if (best[a][b][0] < part[q]) {
+                                part[q] = best[a][b][0];
+                                pidx[q] = (int) ((kv[a][b] + __builtin_shuffle(pos[a][b], li[a][b])[0]) * L + li[a][b][0]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        for (size_t ii = 0; ii < (ic1 - ic0) * R && ic0 * R + ii < m; ++ii) {
+            for (size_t jj = 0; jj < ldp && jc0 * C + jj < q; ++jj) {
+                const float best = part[ii * ldp + jj];
+                r[ld * (ic0 * R + ii) + jc0 * C + jj] = best;
+                p[ld * (ic0 * R + ii) + jc0 * C + jj] = best < inf ? pidx[ii * ldp + jj] : -1;
+            }
+        }
+    }
+};
+
+// 按输出块并行：每个线程从 scratch 中取自己的一段（size 个 float）作为 buf，传给 run_tile / run_tile_argmin
+#define PPC_TILE_LOOP(size, call)                                                        \
+    huge_ptr<float> scratch = scratch_array<float>((size) * omp_get_max_threads());      \
+    _Pragma("omp parallel")                                                              \
+    {                                                                                    \
+        float *buf = scratch.get() + (size) * omp_get_thread_num();                      \
+        _Pragma("omp for schedule(static)")                                              \
+        for (size_t t = 0; t < plan.tiles(); ++t)                                        \
+            call;                                                                        \
+    }
+
+// 三个版本的函数体相同，区别只在 target 属性和 L；S 为半环（semiring.h）
+#define PPC_SIMD_KERNEL_BODY(L, S)                       \
+    SimdPlan<L, S> plan(d, n, ld);                       \
+    if (plan.needs_pack()) {                             \
+        plan.pack(d);                                    \
+        plan.pack_done();                                \
+    }                                                    \
+    PPC_TILE_LOOP(plan.tile_scratch, plan.run_tile(r, t, buf))
+
+// argmin 版本：内层循环与 run_tile 相同，下标在每个 k 分段结束时才确定
+#define PPC_ARGMIN_KERNEL_BODY(L)                        \
+    SimdPlan<L> plan(d, n, ld);                          \
+    if (plan.needs_pack()) {                             \
+        plan.pack(d);                                    \
+        plan.pack_done();                                \
+    }                                                    \
+    PPC_TILE_LOOP(plan.argmin_scratch, plan.run_tile_argmin(r, p, t, buf))
+
+// 长方形版本：r（m×q，行距 ldr）= a（m×n，行距 lda）⊗ b（q×n，行距 ldb）的转置
+#define PPC_PANEL_KERNEL_BODY(L)                         \
+    SimdPlan<L> plan(m, q, n, ldr);                      \
+    plan.pack_a(a, lda);                                 \
+    plan.pack_b(b, ldb);                                 \
+    PPC_TILE_LOOP(plan.tile_scratch, plan.run_tile(r, t, buf))
+
+template <typename S>
+inline void step_semiring_sse(float *r, const float *d, size_t n, size_t ld) {
+    PPC_SIMD_KERNEL_BODY(4, S)
+}
+
+inline void step_simd_sse(float *r, const float *d, size_t n, size_t ld) {
+    step_semiring_sse<MinPlus>(r, d, n, ld);
+}
+
+inline void step_argmin_sse(float *r, int *p, const float *d, size_t n, size_t ld) {
+    PPC_ARGMIN_KERNEL_BODY(4)
+}
+
+inline void step_panel_sse(float *r, size_t ldr, const float *a, size_t lda, const float *b, size_t ldb,
+                           size_t m, size_t q, size_t n) {
+    PPC_PANEL_KERNEL_BODY(4)
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PPC_HAVE_X86_DISPATCH 1
+
+template <typename S>
+__attribute__((target("avx2,fma")))
+inline void step_semiring_avx2(float *r, const float *d, size_t n, size_t ld) {
+    PPC_SIMD_KERNEL_BODY(8, S)
+}
+
+__attribute__((target("avx2,fma")))
+inline void step_simd_avx2(float *r, const float *d, size_t n, size_t ld) {
+    step_semiring_avx2<MinPlus>(r, d, n, ld);
+}
+
+__attribute__((target("avx2,fma")))
+inline void step_argmin_avx2(float *r, int *p, const float *d, size_t n, size_t ld) {
+    PPC_ARGMIN_KERNEL_BODY(8)
+}
+
+__attribute__((target("avx2,fma")))
+inline void step_panel_avx2(float *r, size_t ldr, const float *a, size_t lda, const float *b, size_t ldb,
+                            size_t m, size_t q, size_t n) {
+    PPC_PANEL_KERNEL_BODY(8)
+}
+
+template <typename S>
+__attribute__((target("avx512f")))
+inline void step_semiring_avx512(float *r, const float *d, size_t n, size_t ld) {
+    PPC_SIMD_KERNEL_BODY(16, S)
+}
+
+__attribute__((target("avx512f")))
+inline void step_simd_avx512(float *r, const float *d, size_t n, size_t ld) {
+    step_semiring_avx512<MinPlus>(r, d, n, ld);
+}
+
+__attribute__((target("avx512f")))
+inline void step_argmin_avx512(float *r, int *p, const float *d, size_t n, size_t ld) {
+    PPC_ARGMIN_KERNEL_BODY(16)
+}
+
+__attribute__((target("avx512f")))
+inline void step_panel_avx512(float *r, size_t ldr, const float *a, size_t lda, const float *b, size_t ldb,
+                              size_t m, size_t q, size_t n) {
+    PPC_PANEL_KERNEL_BODY(16)
+}
+
+/* AVX-512 掩码版本：不转置、不补齐
+ * 对 j 方向向量化：r[i][j..j+15] = min_k (d[i][k] 广播) + d[k][j..j+15]，d 的第 k 行本身就是连续的，无需 vt；
+ * 最后不足 16 列的部分用掩码寄存器做 masked load / masked store，因此不需要复制出补齐后的 vd / vt。
+ * 寄存器分块为 6 行 × 64 列：24 个 zmm 累加器 + 4 个 d[k] 向量 + 1 个广播，不超过 32 个 zmm。
+ * k 方向每次 kc 行：d[k0..k1) 的 64 列（kc * 256B）在处理同一列块的 mc 行期间常驻 L2，
+ * 跨 k 段的部分最小值暂存在 r 中。
+ * 每个 r[i][j] 参与比较的和与 step_trans 完全相同（同样的 d[i][k] + d[k][j]），min 与顺序无关，结果逐位一致。
+ */
+__attribute__((target("avx512f")))
+inline void step_avx512_masked(float *r, const float *d, size_t n, size_t ld) {
+    constexpr size_t R = 6, C = 4, L = 16;
+    constexpr size_t kc = 256, mc = 16 * R;
+    const size_t mt = (n + mc - 1) / mc;
+    const size_t nt = (n + C * L - 1) / (C * L);
+
+    // 按列块在外、行块在内编号：相邻线程共享 d 的同一段列
+#pragma omp parallel for schedule(static)
+    for (size_t t = 0; t < mt * nt; ++t) {
+        const size_t i1 = std::min((t % mt + 1) * mc, n);
+        const size_t j0 = (t / mt) * C * L;
+
+        __mmask16 mask[C];
+        for (size_t b = 0; b < C; ++b) {
+            size_t j = j0 + b * L;
+            size_t valid = j < n ? std::min(n - j, L) : 0;
+            mask[b] = (__mmask16) ((1u << valid) - 1);
+        }
+
+        for (size_t k0 = 0; k0 < n; k0 += kc) {
+            const size_t k1 = std::min(k0 + kc, n);
+            for (size_t i0 = (t % mt) * mc; i0 < i1; i0 += R) {
+                // 超出 n 的行重复最后一行参与计算，但不写回
+                const float *x[R];
+                for (size_t a = 0; a < R; ++a)
+                    x[a] = d + ld * std::min(i0 + a, n - 1);
+
+                __m512 vv[R][C];
+                for (size_t a = 0; a < R; ++a)
+                    for (size_t b = 0; b < C; ++b)
+                        vv[a][b] = k0 == 0 || i0 + a >= n
+                                   ? _mm512_set1_ps(inf)
+                                   : _mm512_maskz_loadu_ps(mask[b], r + ld * (i0 + a) + j0 + b * L);
+
+                for (size_t k = k0; k < k1; ++k) {
+                    __m512 y[C];
+                    for (size_t b = 0; b < C; ++b)
+                        y[b] = _mm512_maskz_loadu_ps(mask[b], d + ld * k + j0 + b * L);
+                    for (size_t a = 0; a < R; ++a) {
+                        __m512 xa = _mm512_set1_ps(x[a][k]);
+                        for (size_t b = 0; b < C; ++b)
+                            vv[a][b] = _mm512_min_ps(vv[a][b], _mm512_add_ps(xa, y[b]));
+                    }
+                }
+
+                for (size_t a = 0; a < R && i0 + a < n; ++a)
+                    for (size_t b = 0; b < C; ++b)
+                        _mm512_mask_storeu_ps(r + ld * (i0 + a) + j0 + b * L, mask[b], vv[a][b]);
+            }
+        }
+    }
+}
+#endif
+
+// 当前 CPU 支持的最高级别
+inline SimdIsa detect_isa() {
+#ifdef PPC_HAVE_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdIsa::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdIsa::AVX2;
+#endif
+    return SimdIsa::SSE;
+}
+
+// 实际使用的级别：默认为 detect_isa()，可被 PPC_ISA 覆盖（只能选 CPU 支持的级别）
+inline SimdIsa selected_isa() {
+    static const SimdIsa isa = [] {
+        const SimdIsa best = detect_isa();
+        const char *env = std::getenv("PPC_ISA");
+        if (!env)
+            return best;
+        for (SimdIsa want: {SimdIsa::SSE, SimdIsa::AVX2, SimdIsa::AVX512}) {
+            if (std::strcmp(env, isa_name(want)) == 0) {
+                if (want <= best)
+                    return want;
+                std::cerr << "PPC_ISA=" << env << " is not supported by this CPU, using "
+                          << isa_name(best) << "\n";
+                return best;
+            }
+        }
+        std::cerr << "unknown PPC_ISA=" << env << ", using " << isa_name(best) << "\n";
+        return best;
+    }();
+    return isa;
+}
+
+// 所有内核的 d、r 均为 n×n、行距为 ld（>= n，见 Matrix::get_ld）的矩阵，只读写每行的前 n 列
+typedef void (*step_fn)(float *r, const float *d, size_t n, size_t ld);
+
+inline step_fn simd_kernel(SimdIsa isa) {
+#ifdef PPC_HAVE_X86_DISPATCH
+    if (isa == SimdIsa::AVX512)
+        return step_avx512_masked;
+    if (isa == SimdIsa::AVX2)
+        return step_simd_avx2;
+#endif
+    return step_simd_sse;
+}
+
+// 按 selected_isa() 分派的 min-plus 内核
+inline void step_simd_dispatch(float *r, const float *d, size_t n, size_t ld) {
+    static const step_fn fn = simd_kernel(selected_isa());
+    fn(r, d, n, ld);
+}
+
+// 任意半环（semiring.h）的内核：step_avx512_masked 只有 min-plus 版本，AVX-512 下用 16 lane 的 SimdPlan
+template <typename S>
+inline step_fn semiring_kernel(SimdIsa isa) {
+#ifdef PPC_HAVE_X86_DISPATCH
+    if (isa == SimdIsa::AVX512)
+        return step_semiring_avx512<S>;
+    if (isa == SimdIsa::AVX2)
+        return step_semiring_avx2<S>;
+#endif
+    return step_semiring_sse<S>;
+}
+
+template <typename S>
+inline void step_semiring_dispatch(float *r, const float *d, size_t n, size_t ld) {
+    static const step_fn fn = semiring_kernel<S>(selected_isa());
+    fn(r, d, n, ld);
+}
+
+// 运行时按 SemiringKind 选择，min-plus 即 step_simd_dispatch
+inline step_fn semiring_dispatch(SemiringKind k) {
+    switch (k) {
+        case SemiringKind::MaxPlus: return step_semiring_dispatch<MaxPlus>;
+        case SemiringKind::MaxMin: return step_semiring_dispatch<MaxMin>;
+        case SemiringKind::OrAnd: return step_semiring_dispatch<OrAnd>;
+        default: return step_simd_dispatch;
+    }
+}
+
+// 带 argmin 输出的内核：r[i][j] = min_k d[i][k] + d[k][j]，p[i][j] 为取得最小值的某个 k（不可达时为 -1），p 的行距同样为 ld
+typedef void (*step_argmin_fn)(float *r, int *p, const float *d, size_t n, size_t ld);
+
+inline step_argmin_fn argmin_kernel(SimdIsa isa) {
+#ifdef PPC_HAVE_X86_DISPATCH
+    if (isa == SimdIsa::AVX512)
+        return step_argmin_avx512;
+    if (isa == SimdIsa::AVX2)
+        return step_argmin_avx2;
+#endif
+    return step_argmin_sse;
+}
+
+inline void step_argmin_dispatch(float *r, int *p, const float *d, size_t n, size_t ld) {
+    static const step_argmin_fn fn = argmin_kernel(selected_isa());
+    fn(r, p, d, n, ld);
+}
+
+/* 长方形的 min-plus 乘法：r[i][j] = min_k a[i][k] + b[j][k]，i < m，j < q，k < n
+ * b 按行给出右矩阵的转置（外存版本中即转置文件的一个面板），r、a、b 各有自己的行距
+ */
+typedef void (*step_panel_fn)(float *r, size_t ldr, const float *a, size_t lda, const float *b, size_t ldb,
+                              size_t m, size_t q, size_t n);
+
+inline step_panel_fn panel_kernel(SimdIsa isa) {
+#ifdef PPC_HAVE_X86_DISPATCH
+    if (isa == SimdIsa::AVX512)
+        return step_panel_avx512;
+    if (isa == SimdIsa::AVX2)
+        return step_panel_avx2;
+#endif
+    return step_panel_sse;
+}
+
+inline void step_panel_dispatch(float *r, size_t ldr, const float *a, size_t lda, const float *b, size_t ldb,
+                                size_t m, size_t q, size_t n) {
+    static const step_panel_fn fn = panel_kernel(selected_isa());
+    fn(r, ldr, a, lda, b, ldb, m, q, n);
+}
+
+#pragma GCC diagnostic pop
+
+#endif //DISPATCH_H
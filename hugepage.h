@@ -0,0 +1,186 @@
+/**
+ * 大页（huge page）内存分配
+ * n = 4000 时 d、r、vd、vt 每个都有 60MB 以上，按 4KB 分页就是上万个页；
+ * step_trans 中按列读 d、以及各内核在 vd / vt 的多行之间跳转时，几乎每次访问都落在不同的页上，dTLB 频繁缺失。
+ * 这里按 2MB 大页分配，同样的数据只需几十个 TLB 项：
+ * 1. hugetlb：mmap(MAP_HUGETLB)，直接从 hugetlbfs 预留的大页池中分配，需要事先
+ *    echo N > /proc/sys/vm/nr_hugepages，池中不够时 mmap 失败
+ * 2. thp：按 2MB 对齐分配后 madvise(MADV_HUGEPAGE)，由内核的透明大页（transparent huge pages）合并，
+ *    /sys/kernel/mm/transparent_hugepage/enabled 为 never 时不起作用
+ * 3. 4k：普通的 aligned_alloc
+ * 默认（auto）依次尝试 hugetlb、thp、4k，失败时不报错，静默退回下一种；
+ * 环境变量 PPC_HUGEPAGE=auto|hugetlb|thp|off 可指定策略（用于 A/B 测试），指定的策略不可用时同样退回。
+ * 小于 2MB 的分配不值得用大页，直接按 4k 分配。
+ * 每种策略分配了多少次、多少字节都有统计，page_report() 输出实际使用情况。
+ *
+ * 释放统一用 huge_free（与 std::free 的签名相同，可直接作为 unique_ptr 的删除器），
+ * 它根据内部的登记表判断该用 munmap 还是 free。临时数组用 huge_array<T>(count) 分配；
+ * 内核中则用 scratch_array（workspace.h），调用者提供了工作区时从中借用，否则即 huge_array。
+ */
+
+#ifndef HUGEPAGE_H
+#define HUGEPAGE_H
+
+#pragma once
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+enum class PagePolicy { Small, Transparent, HugeTLB };
+
+inline const char *policy_name(PagePolicy policy) {
+    switch (policy) {
+        case PagePolicy::HugeTLB: return "hugetlb";
+        case PagePolicy::Transparent: return "thp";
+        default: return "4k";
+    }
+}
+
+constexpr size_t huge_page_size = 2 << 20;
+
+namespace hugepage_detail {
+    // mmap 得到的块需要知道长度才能 munmap
+    inline std::mutex &registry_mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    inline std::unordered_map<void *, size_t> &registry() {
+        static std::unordered_map<void *, size_t> r;
+        return r;
+    }
+
+    struct Counter {
+        std::atomic<size_t> count{0}, bytes{0};
+    };
+
+    inline Counter *counters() {
+        static Counter c[3];
+        return c;
+    }
+
+    // 透明大页是否可用：enabled 为 [always] 或 [madvise]
+    inline bool thp_available() {
+        static const bool ok = [] {
+            std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+            std::string s;
+            std::getline(in, s);
+            return s.find("[always]") != std::string::npos || s.find("[madvise]") != std::string::npos;
+        }();
+        return ok;
+    }
+}
+
+// 请求的最高级别：默认 HugeTLB（即 auto，依次退回），可被 PPC_HUGEPAGE 覆盖
+inline PagePolicy requested_policy() {
+    static const PagePolicy policy = [] {
+        const char *env = std::getenv("PPC_HUGEPAGE");
+        if (!env || std::strcmp(env, "auto") == 0 || std::strcmp(env, "hugetlb") == 0)
+            return PagePolicy::HugeTLB;
+        if (std::strcmp(env, "thp") == 0)
+            return PagePolicy::Transparent;
+        if (std::strcmp(env, "off") != 0 && std::strcmp(env, "4k") != 0)
+            std::cerr << "unknown PPC_HUGEPAGE=" << env << ", using 4k pages\n";
+        return PagePolicy::Small;
+    }();
+    return policy;
+}
+
+/* 分配 bytes 字节，起始地址至少 64 字节对齐；used 非空时返回实际使用的策略
+ * 分配失败（内存不足）时返回 nullptr
+ */
+inline void *huge_alloc(size_t bytes, PagePolicy *used = nullptr) {
+    using namespace hugepage_detail;
+    PagePolicy policy = bytes >= huge_page_size ? requested_policy() : PagePolicy::Small;
+    void *p = nullptr;
+
+#ifdef __linux__
+    const size_t rounded = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+    if (policy == PagePolicy::HugeTLB) {
+        p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED) {
+            p = nullptr;
+            policy = PagePolicy::Transparent;
+        } else {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            registry()[p] = rounded;
+        }
+    }
+    if (policy == PagePolicy::Transparent) {
+        if (thp_available() && (p = std::aligned_alloc(huge_page_size, rounded)) != nullptr &&
+            madvise(p, rounded, MADV_HUGEPAGE) == 0) {
+            bytes = rounded;
+        } else {
+            std::free(p);
+            p = nullptr;
+            policy = PagePolicy::Small;
+        }
+    }
+#else
+    policy = PagePolicy::Small;
+#endif
+
+    if (policy == PagePolicy::Small) {
+        bytes = (bytes + 63) / 64 * 64;
+        p = std::aligned_alloc(64, bytes);
+    }
+
+    if (p != nullptr) {
+        counters()[(int) policy].count += 1;
+        counters()[(int) policy].bytes += bytes;
+    }
+    if (used)
+        *used = policy;
+    return p;
+}
+
+// 释放 huge_alloc 分配的内存（nullptr 时什么也不做）
+inline void huge_free(void *p) {
+    using namespace hugepage_detail;
+    if (p == nullptr)
+        return;
+#ifdef __linux__
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto it = registry().find(p);
+        if (it != registry().end()) {
+            munmap(p, it->second);
+            registry().erase(it);
+            return;
+        }
+    }
+#endif
+    std::free(p);
+}
+
+// 输出各策略累计分配的次数与字节数
+inline void page_report(std::ostream &os = std::cout) {
+    using namespace hugepage_detail;
+    os << "page policy (requested " << policy_name(requested_policy()) << "):";
+    for (PagePolicy policy: {PagePolicy::HugeTLB, PagePolicy::Transparent, PagePolicy::Small}) {
+        const Counter &c = counters()[(int) policy];
+        os << " " << policy_name(policy) << " " << c.count << " allocs / " << (c.bytes >> 20) << " MB;";
+    }
+    os << "\n";
+}
+
+template <typename T>
+using huge_ptr = std::unique_ptr<T[], void (*)(void *)>;
+
+// count 个 T 的临时数组（不初始化，T 须为 float、float8_t 之类的平凡类型），离开作用域时自动 huge_free
+template <typename T>
+inline huge_ptr<T> huge_array(size_t count) {
+    return huge_ptr<T>(static_cast<T *>(huge_alloc(count * sizeof(T))), huge_free);
+}
+
+#endif //HUGEPAGE_H
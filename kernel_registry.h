@@ -0,0 +1,66 @@
+/**
+ * 内核注册表
+ * 每个 shortcut_v*.cpp 在文件末尾用 PPC_REGISTER_KERNEL 注册自己的内核（及其参数变体），
+ * 静态对象在 main 之前构造，bench 与 shortcut 库（shortcut.h）按名字查找，不需要知道有哪些内核。
+ * 所有内核的签名都是 step_fn：r、d 为 n×n、行距为 ld 的矩阵（见 dispatch.h）。
+ * 需要特定指令集的内核额外给出 supported()，当前 CPU 不支持时仍然列出，但不会运行。
+ * 注意：这些源文件编进静态库时，没有被引用的目标文件不会被链接进来，注册也就不会发生，
+ * 因此链接静态库 libshortcut.a 时需要 whole-archive（CMake 中已处理）。
+ */
+
+#ifndef KERNEL_REGISTRY_H
+#define KERNEL_REGISTRY_H
+
+#pragma once
+#include <string>
+#include <vector>
+
+#include "dispatch.h"
+
+struct KernelInfo {
+    std::string name;
+    std::string source;              // 定义该内核的源文件，如 "v3-1"
+    step_fn fn;
+    bool (*supported)() = nullptr;   // 为空表示任何 CPU 都可运行
+
+    bool available() const {
+        return supported == nullptr || supported();
+    }
+};
+
+inline std::vector<KernelInfo> &kernel_registry() {
+    static std::vector<KernelInfo> kernels;
+    return kernels;
+}
+
+inline const KernelInfo *find_kernel(const std::string &name) {
+    for (const KernelInfo &k: kernel_registry())
+        if (k.name == name)
+            return &k;
+    return nullptr;
+}
+
+struct KernelRegistrar {
+    KernelRegistrar(const char *file, const char *name, step_fn fn, bool (*supported)() = nullptr) {
+        // ".../shortcut_v3-1.cpp" -> "v3-1"
+        std::string source = file;
+        source = source.substr(source.find_last_of('/') + 1);
+        if (source.rfind("shortcut_", 0) == 0)
+            source = source.substr(9);
+        source = source.substr(0, source.find('.'));
+        kernel_registry().push_back(KernelInfo{name, source, fn, supported});
+    }
+};
+
+#define PPC_CONCAT_(a, b) a##b
+#define PPC_CONCAT(a, b) PPC_CONCAT_(a, b)
+
+/* 在定义内核的源文件中（文件作用域）注册：
+ *     PPC_REGISTER_KERNEL("step_trans", step_trans)
+ *     PPC_REGISTER_KERNEL("step_simd_avx2", step_simd_avx2, [] { return detect_isa() >= SimdIsa::AVX2; })
+ * 参数变体可以用不捕获的 lambda 包装成 step_fn
+ */
+#define PPC_REGISTER_KERNEL(...) \
+    static const KernelRegistrar PPC_CONCAT(ppc_kernel_registrar_, __LINE__)(__FILE__, __VA_ARGS__);
+
+#endif //KERNEL_REGISTRY_H
@@ -0,0 +1,223 @@
+/**
+ * 矩阵的二进制文件格式（.ppcm），可直接 mmap 使用
+ * 文本格式需要逐个解析成 new float[]，大矩阵光启动就要很久；这里把内存中的布局原样写进文件：
+ *
+ *   偏移 0     MatFileHeader（64 字节，小端）
+ *   偏移 4096  rows 行原始数据，每行 ld 个元素（前 cols 个有效，其余为补齐，写出的文件中为 0）
+ *              数据区长度 data_bytes = rows * ld * elem_size 向上补齐到 64 字节
+ *
+ * 数据区从 4096 字节处开始，mmap 得到的起始地址按页对齐；ld 与 Matrix::padded_ld 的取法相同时，
+ * 映射后的每一行与 huge_alloc 分配的矩阵一样按 64 字节对齐，内核可以直接在映射上运行，不需要复制。
+ * 读端只依赖头部记录的 ld，任何 ld >= cols 的文件都能打开；alignment 字段为每行起始地址保证的对齐字节数。
+ *
+ * 出错（文件不存在、格式不对、元素类型不符、文件被截断、rows * ld 过大等）时抛出 std::runtime_error，消息中包含文件名和原因。
+ * Matrix::open_file / Matrix::create_file / Matrix::save 在此基础上提供只读映射、可写映射和写出。
+ */
+
+#ifndef MATFILE_H
+#define MATFILE_H
+
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+enum class ElemType : uint32_t { Float32 = 1, Int32 = 2 };
+
+template <typename T>
+constexpr ElemType elem_type_of() {
+    static_assert(std::is_same<T, float>::value || std::is_same<T, int>::value, "unsupported element type");
+    return std::is_same<T, float>::value ? ElemType::Float32 : ElemType::Int32;
+}
+
+struct MatFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t elem_type;
+    uint32_t elem_size;
+    uint32_t alignment;
+    uint64_t rows, cols, ld;
+    uint64_t data_offset, data_bytes;
+};
+
+static_assert(sizeof(MatFileHeader) == 64, "MatFileHeader must be 64 bytes");
+
+constexpr char matfile_magic[8] = {'P', 'P', 'C', 'M', 'A', 'T', 0, 0};
+constexpr uint32_t matfile_version = 1;
+constexpr uint64_t matfile_data_offset = 4096;
+
+namespace matfile_detail {
+    [[noreturn]] inline void fail(const std::string &path, const std::string &what) {
+        throw std::runtime_error(path + ": " + what);
+    }
+
+    [[noreturn]] inline void fail_errno(const std::string &path, const char *call) {
+        fail(path, std::string(call) + " failed: " + std::strerror(errno));
+    }
+
+    // bytes = rows * ld * elem_size；溢出时返回 false（头部来自文件，不能信任）
+    inline bool data_size(const uint64_t rows, const uint64_t ld, const uint64_t elem_size, uint64_t &bytes) {
+        return !__builtin_mul_overflow(rows, ld, &bytes) && !__builtin_mul_overflow(bytes, elem_size, &bytes);
+    }
+
+    inline void check_header(const MatFileHeader &h, const ElemType type, const uint64_t file_size,
+                             const std::string &path) {
+        if (std::memcmp(h.magic, matfile_magic, sizeof(h.magic)) != 0)
+            fail(path, "not a matrix file");
+        if (h.version != matfile_version)
+            fail(path, "unsupported version " + std::to_string(h.version));
+        if (h.elem_type != (uint32_t) type || h.elem_size != 4)
+            fail(path, "unexpected element type " + std::to_string(h.elem_type));
+        uint64_t need, end;
+        if (h.ld < h.cols || h.data_offset % 4096 != 0 || !data_size(h.rows, h.ld, h.elem_size, need) ||
+            h.data_bytes < need || __builtin_add_overflow(h.data_offset, h.data_bytes, &end) || end > file_size)
+            fail(path, "corrupt header or truncated file");
+    }
+}
+
+// ld < cols，或文件的总长度（data_offset + data_bytes）超出 off_t 的范围时抛出异常，与读端的检查对应
+inline MatFileHeader make_header(const ElemType type, const size_t rows, const size_t cols, const size_t ld,
+                                 const std::string &path) {
+    MatFileHeader h{};
+    std::memcpy(h.magic, matfile_magic, sizeof(h.magic));
+    h.version = matfile_version;
+    h.elem_type = (uint32_t) type;
+    h.elem_size = 4;
+    // 每行起始地址的对齐：行长为 64 字节的倍数时每行都在 cache line 边界上
+    h.alignment = ld * h.elem_size % 64 == 0 ? 64 : h.elem_size;
+    h.rows = rows;
+    h.cols = cols;
+    h.ld = ld;
+    h.data_offset = matfile_data_offset;
+    uint64_t bytes, end;
+    if (ld < cols)
+        matfile_detail::fail(path, "ld < cols");
+    if (!matfile_detail::data_size(rows, ld, h.elem_size, bytes) ||
+        __builtin_add_overflow(bytes, h.data_offset + 63, &end) || end > (uint64_t) INT64_MAX)
+        matfile_detail::fail(path, "matrix too large");
+    h.data_bytes = (bytes + 63) / 64 * 64;
+    return h;
+}
+
+/* 映射到内存的矩阵文件：base 为整个映射的起始地址（即头部），data 为数据区
+ * 由调用者负责 unmap_matrix_file
+ */
+struct MappedMatrix {
+    MatFileHeader header{};
+    void *base = nullptr;
+    size_t bytes = 0;
+
+    void *data() const {
+        return static_cast<char *>(base) + header.data_offset;
+    }
+};
+
+inline void unmap_matrix_file(const MappedMatrix &m) {
+#ifdef __linux__
+    if (m.base)
+        munmap(m.base, m.bytes);
+#endif
+}
+
+#ifdef __linux__
+// 打开已有的矩阵文件并检查头部（写入 h），返回文件描述符，由调用者 close；外存版本直接用它按面板 pread
+inline int open_matrix_fd(const std::string &path, const ElemType type, MatFileHeader &h,
+                          const bool writable = false) {
+    using namespace matfile_detail;
+    const int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+        fail_errno(path, "open");
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(MatFileHeader) ||
+        pread(fd, &h, sizeof(h), 0) != (ssize_t) sizeof(h)) {
+        ::close(fd);
+        fail(path, "cannot read header");
+    }
+    try {
+        check_header(h, type, st.st_size, path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    return fd;
+}
+
+// 新建（或覆盖）一个 rows×cols、行距为 ld 的矩阵文件：写入头部并扩展到完整长度（数据区为 0），返回可读写的文件描述符
+inline int create_matrix_fd(const std::string &path, const ElemType type, const size_t rows, const size_t cols,
+                            const size_t ld, MatFileHeader &h) {
+    using namespace matfile_detail;
+    h = make_header(type, rows, cols, ld, path);
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        fail_errno(path, "open");
+    if (ftruncate(fd, (off_t) (h.data_offset + h.data_bytes)) != 0 ||
+        pwrite(fd, &h, sizeof(h), 0) != (ssize_t) sizeof(h)) {
+        ::close(fd);
+        fail_errno(path, "write");
+    }
+    return fd;
+}
+
+// 打开已有的矩阵文件并映射；writable 为 false 时只读映射（PROT_READ），写入会触发 SIGSEGV
+inline MappedMatrix map_matrix_file(const std::string &path, const ElemType type, const bool writable = false) {
+    MappedMatrix m;
+    const int fd = open_matrix_fd(path, type, m.header, writable);
+    m.bytes = m.header.data_offset + m.header.data_bytes;
+    m.base = mmap(nullptr, m.bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m.base == MAP_FAILED)
+        matfile_detail::fail_errno(path, "mmap");
+    if (!writable) // 内核会顺序地预读，大文件首次访问不必逐页缺页
+        madvise(m.base, m.bytes, MADV_WILLNEED);
+    return m;
+}
+
+// 新建矩阵文件并可写地映射，数据区初始为 0；写入直接落到文件里
+inline MappedMatrix create_matrix_file(const std::string &path, const ElemType type,
+                                       const size_t rows, const size_t cols, const size_t ld) {
+    MappedMatrix m;
+    const int fd = create_matrix_fd(path, type, rows, cols, ld, m.header);
+    m.bytes = m.header.data_offset + m.header.data_bytes;
+    m.base = mmap(nullptr, m.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m.base == MAP_FAILED)
+        matfile_detail::fail_errno(path, "mmap");
+    return m;
+}
+#endif
+
+// 把内存中 rows×cols、行距为 ld 的矩阵写成文件（按原样的行距写出，不需要映射）
+// 每行只写出前 cols 个元素，补齐部分写 0：内存中的补齐可能未初始化，不能原样落盘
+template <typename T>
+inline void write_matrix_file(const std::string &path, const T *p, const size_t rows, const size_t cols,
+                              const size_t ld) {
+    using namespace matfile_detail;
+    const MatFileHeader h = make_header(elem_type_of<T>(), rows, cols, ld, path);
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f)
+        fail_errno(path, "fopen");
+    std::vector<char> pad(h.data_offset - sizeof(h), 0);
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 && std::fwrite(pad.data(), 1, pad.size(), f) == pad.size();
+    const std::vector<T> tail(ld - cols, T{});
+    for (size_t i = 0; i < rows && ok; ++i)
+        ok = std::fwrite(p + ld * i, sizeof(T), cols, f) == cols &&
+             std::fwrite(tail.data(), sizeof(T), tail.size(), f) == tail.size();
+    pad.assign(h.data_bytes - rows * ld * sizeof(T), 0);
+    ok = ok && std::fwrite(pad.data(), 1, pad.size(), f) == pad.size();
+    if (std::fclose(f) != 0 || !ok)
+        fail_errno(path, "write");
+}
+
+#endif //MATFILE_H
@@ -6,65 +6,188 @@
 #define MATRIX_H
 
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
-#include <random>
+#include <new>
+#include <utility>
 
+#include "hugepage.h"
+#include "matfile.h"
+#include "numa_aware.h"
+#include "rng.h"
+
+/* n×n 方阵，独占一块 n*ld 个 float 的内存
+ * 1. 起始地址按 alignment（64 字节，一条 cache line，也满足 AVX-512 对齐访问）对齐，
+ *    总字节数向上补齐到 alignment 的倍数（aligned_alloc 的要求），因此按向量读到最后一个元素也不会越界；
+ *    内存由 huge_alloc 分配，大矩阵尽量使用 2MB 大页（见 hugepage.h），get_page_policy() 为实际使用的策略
+ * 2. 只能移动不能复制：大矩阵动辄上 GB，避免无意中的深拷贝
+ * 3. 行与行之间有补齐：第 i 行从 pData[i * ld] 开始，ld（leading dimension）>= n，
+ *    补出来的列内容未定义，所有内核按 (n, ld) 访问，只读写前 n 列
+ * 4. get_pdata() 为按行存放的 float 视图，get_vdata<V>() 为同一块内存的向量视图（如 get_vdata<float8_t>()），
+ *    默认的 ld 是 16 的倍数，因此每一行都从一个完整的向量开始
+ * 5. NUMA 模式下（见 numa_aware.h）分配后先按行 schedule(static) 并行首次写入，各行的页落在随后计算这些行的线程所在的节点上
+ * 6. 也可以直接映射矩阵文件（见 matfile.h），不复制：open_file 只读映射已有的文件（写入会触发 SIGSEGV），
+ *    create_file 新建文件并可写地映射，结果直接写进文件；ld 沿用文件中记录的行距。save 把矩阵写成文件
+ *
+ * ld 的选取（padded_ld）：n 为 2 的较大次幂的倍数（如 2048、4096）时，相邻行相距 4KB 的整数倍，
+ * 同一列上的元素落在 L1 的同一组（set）里，几行就把这一组的 8 路占满，还会触发 4K aliasing，
+ * 这些 n 比相邻的 n 慢得多。这里先补齐到整条 cache line（16 个 float），
+ * 再保证每行占奇数条 cache line，相邻行依次错开到不同的组，代价至多 32 个 float / 行。
+ */
 class Matrix {
 	// 设置为方阵
 private:
 	size_t n = 0;
+	size_t ld = 0;
 	float *pData = nullptr;
+	PagePolicy policy = PagePolicy::Small;
+	MappedMatrix file{}; // 映射到文件时 file.base 非空，pData 指向其数据区
+	bool writable = true;
+
+	Matrix(const MappedMatrix &m, const bool writable)
+		: n(m.header.rows), ld(m.header.ld), pData(static_cast<float *>(m.data())), file(m), writable(writable) {
+	}
 
 public:
-	explicit Matrix(const size_t n, const float val = 0.f, const bool rand = false): n(n) {
-		pData = new float[n * n * sizeof(float)];
+	static constexpr size_t alignment = 64;
+
+	// n 列的方阵默认使用的行距：整数条、且为奇数条 cache line
+	static size_t padded_ld(const size_t n) {
+		constexpr size_t line = alignment / sizeof(float);
+		size_t lines = (n + line - 1) / line;
+		if (lines % 2 == 0 && lines > 0)
+			++lines;
+		return lines * line;
+	}
+
+	/* stride 为 0 时自动选取行距（padded_ld），否则使用给定的行距（须 >= n，stride = n 即不补齐）
+	 * rand 为 true 时按 seed 生成随机矩阵（见 rng.h），同一个 seed 得到的矩阵与 stride、线程数无关
+	 */
+	explicit Matrix(const size_t n, const float val = 0.f, const bool rand = false, const size_t stride = 0,
+	                const uint64_t seed = random_seed())
+		: n(n), ld(stride ? std::max(stride, n) : padded_ld(n)) {
+		const size_t bytes = (n * ld * sizeof(float) + alignment - 1) / alignment * alignment;
+		pData = static_cast<float *>(huge_alloc(bytes, &policy));
+		if (bytes != 0 && pData == nullptr)
+			throw std::bad_alloc();
+		if (numa_enabled())
+			numa_first_touch(pData, n, ld);
 		if (val != 0.f) {
 			for (size_t i = 0; i < n; ++i) {
 				for (size_t j = 0; j < n; ++j) {
 					if (i == j) {
-						pData[i * n + j] = 0.f; // 对角线元素设为 0
+						pData[i * ld + j] = 0.f; // 对角线元素设为 0
 					} else {
-						pData[i * n + j] = val;
+						pData[i * ld + j] = val;
 					}
 				}
 			}
 		}
-		if (rand) {
-			std::random_device rd;
-			std::mt19937 gen(rd());
-			std::uniform_real_distribution<> dis(1.0, 20.0);
+		if (rand)
+			fill_random(pData, n, ld, seed);
+	}
 
-			for (size_t i = 0; i < n; ++i) {
-				for (size_t j = 0; j < n; ++j) {
-					if (i == j) {
-						pData[i * n + j] = 0.f; // 对角线元素设为 0
-					} else {
-						float random_value = dis(gen);
-						float rounded_value = std::round(random_value * 100.0) / 100.0;
-						pData[i * n + j] = rounded_value;
-					}
-				}
-			}
+	Matrix(const Matrix &) = delete;
+
+	Matrix &operator=(const Matrix &) = delete;
+
+	Matrix(Matrix &&other) noexcept
+		: n(other.n), ld(other.ld), pData(other.pData), policy(other.policy), file(other.file), writable(other.writable) {
+		other.n = 0;
+		other.ld = 0;
+		other.pData = nullptr;
+		other.file = MappedMatrix{};
+	}
+
+	Matrix &operator=(Matrix &&other) noexcept {
+		std::swap(n, other.n);
+		std::swap(ld, other.ld);
+		std::swap(pData, other.pData);
+		std::swap(policy, other.policy);
+		std::swap(file, other.file);
+		std::swap(writable, other.writable);
+		return *this;
+	}
+
+#ifdef __linux__
+	// 只读映射矩阵文件，文件须为 float 方阵
+	static Matrix open_file(const std::string &path) {
+		MappedMatrix m = map_matrix_file(path, ElemType::Float32);
+		if (m.header.rows != m.header.cols) {
+			unmap_matrix_file(m);
+			throw std::runtime_error(path + ": not a square matrix");
 		}
+		return Matrix(m, false);
+	}
+
+	// 新建 n×n 的矩阵文件并可写地映射，初始全为 0；stride 的含义与构造函数相同
+	static Matrix create_file(const std::string &path, const size_t n, const size_t stride = 0) {
+		const size_t ld = stride ? std::max(stride, n) : padded_ld(n);
+		return Matrix(create_matrix_file(path, ElemType::Float32, n, n, ld), true);
+	}
+
+	// 可写映射：把修改同步写回文件（析构时内核也会写回，这里用于需要确认落盘的场合）
+	void sync() const {
+		if (file.base && writable)
+			msync(file.base, file.bytes, MS_SYNC);
+	}
+#endif
+
+	// 按当前的行距写成矩阵文件
+	void save(const std::string &path) const {
+		write_matrix_file(path, pData, n, n, ld);
 	}
 
 	void print() const {
 		for (int i = 0; i < n; ++i) {
 			for (int j = 0; j < n; ++j) {
-				std::cout << std::fixed << std::setw(6) << std::setprecision(2) << pData[i * n + j] << " ";
+				std::cout << std::fixed << std::setw(6) << std::setprecision(2) << pData[i * ld + j] << " ";
 			}
 			std::cout << "\n";
 		}
 	}
 
 	~Matrix() {
-		delete []pData;
+		if (file.base)
+			unmap_matrix_file(file);
+		else
+			huge_free(pData);
+	}
+
+	size_t size() const {
+		return n;
+	}
+
+	size_t get_ld() const {
+		return ld;
+	}
+
+	PagePolicy get_page_policy() const {
+		return policy;
+	}
+
+	bool is_mapped() const {
+		return file.base != nullptr;
+	}
+
+	bool is_read_only() const {
+		return !writable;
 	}
 
 	float *get_pdata() const {
 		return pData;
 	}
+
+	// 向量视图，V 为 GCC 向量类型（float8_t、floatv_t<L> 等），共 (n*ld + L - 1) / L 个向量
+	template <typename V>
+	V *get_vdata() const {
+		static_assert(sizeof(V) % sizeof(float) == 0 && alignment % alignof(V) == 0,
+		              "V must be a float vector type no wider than Matrix::alignment");
+		return reinterpret_cast<V *>(pData);
+	}
 };
 
 #endif //MATRIX_H
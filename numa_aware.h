@@ -0,0 +1,309 @@
+/**
+ * NUMA 感知的首次访问（first-touch）初始化
+ * Linux 默认的内存策略是“谁先写谁拥有”：页在第一次被写时才分配，并放在执行这次写入的 CPU 所在的节点上。
+ * Matrix 原先在构造函数中单线程填充，所有页都落在主线程所在的 socket 上，
+ * 双路机器上 step_trans_ilp_omp / step_trans_simd_omp 中另一个 socket 的线程读的全是远端内存。
+ * NUMA 模式下：
+ * 1. numa_pin_threads() 把 OpenMP 线程绑定（pin）到 CPU 上：CPU 按节点顺序排列，线程 t（共 T 个）绑定到第 t * ncpu / T 个，
+ *    编号相邻的线程在同一个节点上，schedule(static) 分给它们的相邻行也就在同一个节点上；
+ *    绑定会改变调用线程自己的亲和性，因此由可执行程序（bench、shortcut_apsp、shortcut_ooc）在 main 开头显式调用，库不会自动绑定
+ * 2. Matrix 以及各内核中的转置 / 补齐副本都按行 schedule(static) 并行地首次写入，
+ *    与随后计算时的 schedule(static) 划分相同：第 i 行由哪个线程计算，就由哪个线程首次写入，落在该线程的节点上
+ * 注意只有按行划分访问的数据（d 的行、r 的行、vd 的行）能做到全部本地访问；t / vt 的每一行都会被所有线程读到，
+ * 按行分散到各个节点上至少使各节点的带宽被均匀使用，而不是全部挤在一个 socket 上。
+ *
+ * 环境变量 PPC_NUMA=auto|on|off：默认 auto，只在多于一个节点的机器上开启；
+ * 线程数在绑定之后再改变（omp_set_num_threads）时新增的线程不会被绑定。
+ * numa_report() 输出一块按行存放的数据在各节点上的页数，以及各节点上的线程读自己那部分行的带宽和本地页比例，用于确认局部性。
+ * 不依赖 libnuma：节点拓扑读 /sys/devices/system/node，页所在节点用 move_pages 系统调用查询；非 Linux 上退化为单节点。
+ */
+
+#ifndef NUMA_AWARE_H
+#define NUMA_AWARE_H
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace numa_detail {
+    struct Topology {
+        std::vector<std::vector<int>> node_cpus; // 每个节点上本进程可用的 CPU
+        std::vector<int> cpu_node;               // CPU 编号 -> 节点编号
+    };
+
+    // "0-3,8-11" 形式的 CPU 列表
+    inline std::vector<int> parse_cpulist(const std::string &s) {
+        std::vector<int> cpus;
+        std::stringstream ss(s);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (item.empty() || item[0] == '\n')
+                continue;
+            const size_t dash = item.find('-');
+            const int lo = std::atoi(item.c_str());
+            const int hi = dash == std::string::npos ? lo : std::atoi(item.c_str() + dash + 1);
+            for (int c = lo; c <= hi; ++c)
+                cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    inline const Topology &topology() {
+        static const Topology topo = [] {
+            Topology t;
+#ifdef __linux__
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            const bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+            for (int node = 0;; ++node) {
+                std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                if (!in)
+                    break;
+                std::string s;
+                std::getline(in, s);
+                std::vector<int> cpus;
+                for (int c: parse_cpulist(s)) {
+                    if (c >= (int) t.cpu_node.size())
+                        t.cpu_node.resize(c + 1, 0);
+                    t.cpu_node[c] = node;
+                    if (!have_mask || (c < CPU_SETSIZE && CPU_ISSET(c, &allowed)))
+                        cpus.push_back(c);
+                }
+                t.node_cpus.push_back(cpus);
+            }
+            // 没有 sysfs（容器、非 NUMA 内核）时视为单节点
+            if (t.node_cpus.empty()) {
+                std::vector<int> cpus;
+                for (int c = 0; c < CPU_SETSIZE; ++c)
+                    if (have_mask && CPU_ISSET(c, &allowed))
+                        cpus.push_back(c);
+                t.node_cpus.push_back(cpus);
+            }
+#else
+            t.node_cpus.emplace_back();
+#endif
+            return t;
+        }();
+        return topo;
+    }
+
+    // 按节点顺序排列的 CPU，绑定线程时按这个顺序分配
+    inline std::vector<int> ordered_cpus() {
+        std::vector<int> cpus;
+        for (const auto &node: topology().node_cpus)
+            cpus.insert(cpus.end(), node.begin(), node.end());
+        return cpus;
+    }
+
+    inline int thread_index() {
+#ifdef _OPENMP
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
+
+    inline int thread_count() {
+#ifdef _OPENMP
+        return omp_get_num_threads();
+#else
+        return 1;
+#endif
+    }
+
+    // 把调用线程绑定到 ordered_cpus 中的第 t * ncpu / T 个 CPU 上
+    inline void pin_current_thread(const std::vector<int> &cpus) {
+#ifdef __linux__
+        if (cpus.empty())
+            return;
+        const size_t t = thread_index(), T = thread_count();
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[t * cpus.size() / T], &set);
+        sched_setaffinity(0, sizeof(set), &set);
+#else
+        (void) cpus;
+#endif
+    }
+}
+
+inline size_t numa_nodes() {
+    return numa_detail::topology().node_cpus.size();
+}
+
+// 当前线程所在的节点（未知时为 0）
+inline int current_node() {
+#ifdef __linux__
+    const int cpu = sched_getcpu();
+    const auto &map = numa_detail::topology().cpu_node;
+    if (cpu >= 0 && cpu < (int) map.size())
+        return map[cpu];
+#endif
+    return 0;
+}
+
+// 是否开启 NUMA 模式；第一次调用时读取 PPC_NUMA。Matrix 的构造函数据此决定是否并行首次写入，不改变任何线程的亲和性
+inline bool numa_enabled() {
+    static const bool enabled = [] {
+        const char *env = std::getenv("PPC_NUMA");
+        bool on = numa_nodes() > 1;
+        if (env && std::strcmp(env, "on") == 0)
+            on = true;
+        else if (env && std::strcmp(env, "off") == 0)
+            on = false;
+        else if (env && std::strcmp(env, "auto") != 0)
+            std::cerr << "unknown PPC_NUMA=" << env << ", using auto\n";
+        return on;
+    }();
+    return enabled;
+}
+
+/* NUMA 模式下绑定 OpenMP 线程（包括调用线程，它是线程 0），只在第一次调用时进行；非 NUMA 模式下什么也不做
+ * 应在分配第一个矩阵之前调用，之后的首次写入与计算都在固定的 CPU 上
+ */
+inline void numa_pin_threads() {
+    static const bool pinned = [] {
+        if (!numa_enabled())
+            return false;
+        const std::vector<int> cpus = numa_detail::ordered_cpus();
+#pragma omp parallel
+        numa_detail::pin_current_thread(cpus);
+        return true;
+    }();
+    (void) pinned;
+}
+
+/* 按行并行地首次写入 rows 行、每行 stride 个 T（含补齐部分），划分方式与计算时的 schedule(static) 相同
+ * 只在 NUMA 模式下需要；写入的内容为 val，调用者随后可以再按任意方式覆盖
+ */
+template <typename T>
+inline void numa_first_touch(T *p, const size_t rows, const size_t stride, const T val = T{}) {
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < rows; ++i)
+        std::fill(p + stride * i, p + stride * (i + 1), val);
+}
+
+/* 各页所在的节点（与 addrs 一一对应，查询失败或页尚未分配时为 -1）
+ * move_pages 的 nodes 参数为空时只查询、不迁移
+ */
+inline std::vector<int> page_nodes(const std::vector<void *> &addrs) {
+    std::vector<int> status(addrs.size(), -1);
+#if defined(__linux__) && defined(SYS_move_pages)
+    if (!addrs.empty() &&
+        syscall(SYS_move_pages, 0, addrs.size(), addrs.data(), nullptr, status.data(), 0) != 0)
+        std::fill(status.begin(), status.end(), -1);
+#endif
+    for (int &s: status)
+        if (s < 0)
+            s = -1;
+    return status;
+}
+
+/* 输出按行存放的数据 p（rows 行，每行 row_bytes 字节）的局部性：
+ * 1. 各节点上的页数（每个 4KB 页查询一次，大数据按等间距抽样至多 64K 个页）
+ * 2. 每个线程按 schedule(static) 读自己的那部分行，按线程所在节点汇总：线程数、读带宽、所读页中位于本节点的比例
+ * NUMA 模式关闭时线程未绑定，结果只作参考
+ */
+inline void numa_report(const char *name, const void *p, const size_t rows, const size_t row_bytes,
+                        std::ostream &os = std::cout) {
+    const char *base = static_cast<const char *>(p);
+    const size_t bytes = rows * row_bytes, nodes = numa_nodes();
+    constexpr size_t page = 4096, max_samples = 1 << 16;
+    const size_t step = std::max(page, (bytes / max_samples + page - 1) / page * page);
+
+    std::vector<void *> addrs;
+    for (size_t off = 0; off < bytes; off += step)
+        addrs.push_back(const_cast<char *>(base + off));
+    std::vector<int> where = page_nodes(addrs);
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+
+    os << name << ": " << (bytes >> 20) << " MB, " << nodes << " node(s), mode " << (numa_enabled() ? "on" : "off")
+       << "\n  pages:";
+    std::vector<size_t> per_node(nodes + 1, 0);
+    for (int w: where)
+        ++per_node[w >= 0 && w < (int) nodes ? w : nodes];
+    for (size_t node = 0; node < nodes; ++node)
+        os << " node" << node << " " << std::fixed << std::setprecision(1)
+           << 100.0 * per_node[node] / std::max<size_t>(where.size(), 1) << "%";
+    if (per_node[nodes])
+        os << " unknown " << 100.0 * per_node[nodes] / where.size() << "%";
+    os << "\n";
+
+    // 每个节点：线程数、读到的字节数、最慢线程的耗时、本地 / 已知页数
+    struct NodeStat {
+        size_t threads = 0, bytes = 0, local = 0, known = 0;
+        double seconds = 0;
+    };
+    std::vector<NodeStat> stat(nodes);
+    float sink = 0;
+#pragma omp parallel reduction(+:sink)
+    {
+        const size_t t = numa_detail::thread_index(), T = numa_detail::thread_count();
+        // 与 schedule(static) 相同的连续划分：前 rows % T 个线程各多一行
+        const size_t q = rows / T, rem = rows % T;
+        const size_t r0 = t * q + std::min(t, rem), r1 = r0 + q + (t < rem);
+        const int node = std::min<int>(current_node(), (int) nodes - 1);
+
+        // 按 64 字节读，每条 cache line 取一个 float
+        auto start = std::chrono::high_resolution_clock::now();
+        float acc = 0;
+        for (size_t off = r0 * row_bytes; off < r1 * row_bytes; off += 64)
+            acc += *reinterpret_cast<const float *>(base + off);
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        sink += acc;
+
+        size_t local = 0, known = 0;
+        for (size_t s = r0 * row_bytes / step; s < where.size() && s * step < r1 * row_bytes; ++s) {
+            if (where[s] >= 0) {
+                ++known;
+                local += where[s] == node;
+            }
+        }
+#pragma omp critical
+        {
+            NodeStat &ns = stat[node];
+            ns.threads += 1;
+            ns.bytes += (r1 - r0) * row_bytes;
+            ns.seconds = std::max(ns.seconds, elapsed.count());
+            ns.local += local;
+            ns.known += known;
+        }
+    }
+
+    for (size_t node = 0; node < nodes; ++node) {
+        const NodeStat &ns = stat[node];
+        if (ns.threads == 0)
+            continue;
+        os << "  node" << node << ": " << ns.threads << " thread(s), " << std::setprecision(2)
+           << ns.bytes / std::max(ns.seconds, 1e-9) / 1e9 << " GB/s, local pages ";
+        if (ns.known)
+            os << std::setprecision(1) << 100.0 * ns.local / ns.known << "%\n";
+        else
+            os << "unknown\n";
+    }
+    os.flags(flags);
+    os.precision(precision);
+    volatile float keep = sink; // 防止读循环被优化掉
+    (void) keep;
+}
+
+#endif //NUMA_AWARE_H
@@ -0,0 +1,269 @@
+/**
+ * 外存（out-of-core）版本的 min-plus 乘法：输入、输出都是矩阵文件（见 matfile.h），内存中只保留几个面板
+ * Matrix 整个放在内存里，n 在 3 万左右就放不下了（n = 100000 时一个矩阵 40GB）。
+ * r[i][j] = min_k d[i][k] + t[j][k]，t 为 d 的转置，因此 r 的一个 P 行 × P 列的面板只依赖 d 的 P 行（行面板）和 t 的 P 行（列面板），
+ * 两者在文件中都是连续的：
+ * 1. 先把 d 转置写入临时文件 t（读一遍 d、写一遍 t），之后列面板也可以整块顺序读取
+ * 2. 对每个行面板 I：依次读 t 的各个列面板 J，用 step_panel_dispatch（与 step_simd_dispatch 相同的分块内核）
+ *    算出 r 的 (I, J) 块；整个行面板算完后写回输出文件
+ * 三种 I/O 都与计算重叠（double buffering）：
+ * - 计算列面板 J 的同时后台线程读入下一个列面板
+ * - 计算行面板 I 的同时后台线程读入下一个行面板
+ * - 行面板 I 的结果在后台写回，同时计算行面板 I + 1（输出缓冲区也有两份）
+ * 列面板按蛇形顺序访问（偶数行面板 0, 1, ..., 奇数行面板倒序），相邻两个行面板交界处的列面板已在内存中，不必重读。
+ *
+ * 内存：行面板、列面板、输出面板各两份，共 6 * P * ld * 4 字节，另有内核内部打包的 vd、vt 约 2 * P * ld * 4 字节；
+ * P 由 memory_budget 推出（取 96 的倍数，即 SimdPlan 中 mc * 3），也可直接指定。
+ * I/O 量：每个行面板都要读一遍 t，共约 n * ld * 4 * (n / P) 字节，P 越大读得越少；
+ * 计算量为 P * n * n / 行面板，n 较大时单个面板的计算时间足以掩盖读盘时间。
+ * 出错时抛出 std::runtime_error（包括后台线程中的读写错误），临时文件会被删除。
+ */
+
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "dispatch.h"
+#include "matfile.h"
+#include "pack.h"
+
+#ifdef __linux__
+
+struct OocOptions {
+    size_t memory_budget = size_t(1) << 30; // 面板缓冲区可用的内存（字节）
+    size_t panel_rows = 0;                  // 每个面板的行数，为 0 时由 memory_budget 推出
+    std::string tmp_path;                   // 转置文件，为空时为输出文件名加 ".t"
+};
+
+struct OocStats {
+    size_t panel_rows = 0, panels = 0;
+    size_t bytes_read = 0, bytes_written = 0;
+    double transpose_seconds = 0; // 第一步（转置）的总时间
+    double io_wait_seconds = 0;   // 第二步中计算线程等待 I/O 的时间，接近 0 说明 I/O 已被计算完全掩盖
+    double compute_seconds = 0;
+};
+
+namespace ooc_detail {
+    struct Fd {
+        int fd = -1;
+
+        ~Fd() {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    };
+
+    // 读入第 [i0, i0 + rows) 行（每行 h.ld 个 float）
+    inline void read_rows(const int fd, const MatFileHeader &h, const size_t i0, const size_t rows, float *buf,
+                          const std::string &path) {
+        char *p = reinterpret_cast<char *>(buf);
+        size_t left = rows * h.ld * sizeof(float);
+        off_t off = (off_t) (h.data_offset + i0 * h.ld * sizeof(float));
+        while (left > 0) {
+            const ssize_t got = pread(fd, p, left, off);
+            if (got <= 0)
+                matfile_detail::fail_errno(path, "pread");
+            p += got;
+            off += got;
+            left -= got;
+        }
+    }
+
+    inline void write_rows(const int fd, const MatFileHeader &h, const size_t i0, const size_t rows,
+                           const float *buf, const std::string &path) {
+        const char *p = reinterpret_cast<const char *>(buf);
+        size_t left = rows * h.ld * sizeof(float);
+        off_t off = (off_t) (h.data_offset + i0 * h.ld * sizeof(float));
+        while (left > 0) {
+            const ssize_t put = pwrite(fd, p, left, off);
+            if (put <= 0)
+                matfile_detail::fail_errno(path, "pwrite");
+            p += put;
+            off += put;
+            left -= put;
+        }
+    }
+
+    inline double seconds_since(const std::chrono::high_resolution_clock::time_point &start) {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    /* 把 d（fd）转置写入 t（tfd）：每次读 d 的 P 行，按 P×P 的块转置到 block 中，
+     * 再把块的每一行（t 的第 j 行的 [i0, i1) 段）写回 t
+     */
+    inline void transpose_file(const int fd, const MatFileHeader &h, const int tfd, const MatFileHeader &ht,
+                               const size_t P, float *panel, float *block, const std::string &path,
+                               const std::string &tpath) {
+        const size_t n = h.rows, ld = h.ld;
+        for (size_t i0 = 0; i0 < n; i0 += P) {
+            const size_t ni = std::min(P, n - i0);
+            read_rows(fd, h, i0, ni, panel, path);
+            for (size_t j0 = 0; j0 < n; j0 += P) {
+                const size_t nj = std::min(P, n - j0);
+                // block[jj * P + ii] = panel[ld * ii + j0 + jj]（pack.h）
+                pack_cols(RowLayout{block, P}, nj, ni, panel + j0, ni, nj, ld);
+                for (size_t jj = 0; jj < nj; ++jj) {
+                    const off_t off = (off_t) (ht.data_offset + ((j0 + jj) * ht.ld + i0) * sizeof(float));
+                    if (pwrite(tfd, block + jj * P, ni * sizeof(float), off) != (ssize_t) (ni * sizeof(float)))
+                        matfile_detail::fail_errno(tpath, "pwrite");
+                }
+            }
+        }
+    }
+}
+
+// 面板行数：memory_budget 能放下的最大的 96 的倍数（至少 3 行，不超过 n）
+inline size_t ooc_panel_rows(const size_t n, const size_t ld, const OocOptions &opt) {
+    size_t P = opt.panel_rows;
+    if (P == 0) {
+        P = opt.memory_budget / (8 * ld * sizeof(float));
+        P = P >= 96 ? P / 96 * 96 : std::max<size_t>(P / 3 * 3, 3);
+    }
+    return std::max<size_t>(std::min(P, n), 1);
+}
+
+/* 对矩阵文件 in_path 做一次 min-plus 平方，结果写入矩阵文件 out_path（行距与输入相同）
+ * 与 step_simd_dispatch(r, d, n, ld) 的结果逐位相同
+ */
+inline OocStats step_out_of_core(const std::string &in_path, const std::string &out_path,
+                                 const OocOptions &opt = OocOptions{}) {
+    using namespace ooc_detail;
+    typedef std::chrono::high_resolution_clock clock;
+    MatFileHeader h{}, ht{}, hr{};
+    Fd in, tf, out;
+    in.fd = open_matrix_fd(in_path, ElemType::Float32, h);
+    if (h.rows != h.cols)
+        throw std::runtime_error(in_path + ": not a square matrix");
+    const size_t n = h.rows, ld = h.ld;
+    const std::string tmp_path = opt.tmp_path.empty() ? out_path + ".t" : opt.tmp_path;
+
+    OocStats stats;
+    const size_t P = ooc_panel_rows(n, ld, opt);
+    const size_t panels = n == 0 ? 0 : (n + P - 1) / P;
+    stats.panel_rows = P;
+    stats.panels = panels;
+
+    // a: 行面板，b: 列面板，c: 输出面板，各两份
+    huge_ptr<float> a[2] = {huge_array<float>(P * ld), huge_array<float>(P * ld)};
+    huge_ptr<float> b[2] = {huge_array<float>(P * ld), huge_array<float>(P * ld)};
+    huge_ptr<float> c[2] = {huge_array<float>(P * ld), huge_array<float>(P * ld)};
+    for (float *buf: {a[0].get(), a[1].get(), b[0].get(), b[1].get(), c[0].get(), c[1].get()})
+        if (buf == nullptr)
+            throw std::bad_alloc();
+    // 各面板乘积的打包副本（vd / vt）大小相同，在面板之间复用
+    Workspace panel_ws;
+    // 输出面板每行 n 之后的补齐部分不会被内核写到，写入 inf 以免把未初始化的内存写进文件
+    for (auto &buf: c)
+        std::fill(buf.get(), buf.get() + P * ld, inf);
+
+    // 第一步：转置（借用 b[0]、b[1] 作为读缓冲和转置块，P * P <= P * ld）
+    auto start = clock::now();
+    tf.fd = create_matrix_fd(tmp_path, ElemType::Float32, n, n, ld, ht);
+    try {
+        transpose_file(in.fd, h, tf.fd, ht, P, b[0].get(), b[1].get(), in_path, tmp_path);
+    } catch (...) {
+        std::remove(tmp_path.c_str());
+        throw;
+    }
+    stats.transpose_seconds = seconds_since(start);
+    stats.bytes_read += n * ld * sizeof(float);
+    stats.bytes_written += n * ld * sizeof(float);
+
+    // 第二步：按面板计算
+    std::future<void> read_a, read_b, write_c;
+    int have[2] = {-1, -1}; // b[s] 中是哪个列面板
+    int pending = -1;       // read_b 正在读的列面板（读入 b[pending_slot]）
+    size_t pending_slot = 0;
+    auto rows_of = [&](size_t p) { return std::min(P, n - p * P); };
+    // 等待后台 I/O，计入 io_wait_seconds；get() 会重新抛出后台线程中的异常
+    auto wait = [&](std::future<void> &f) {
+        if (!f.valid())
+            return;
+        auto t0 = clock::now();
+        f.get();
+        stats.io_wait_seconds += seconds_since(t0);
+    };
+
+    try {
+        out.fd = create_matrix_fd(out_path, ElemType::Float32, n, n, ld, hr);
+        if (panels > 0)
+            read_rows(in.fd, h, 0, rows_of(0), a[0].get(), in_path);
+        for (size_t I = 0; I < panels; ++I) {
+            float *ai = a[I % 2].get(), *ci = c[I % 2].get();
+            wait(read_a);
+            if (I + 1 < panels) {
+                float *next = a[(I + 1) % 2].get();
+                read_a = std::async(std::launch::async, [&, I, next] {
+                    read_rows(in.fd, h, (I + 1) * P, rows_of(I + 1), next, in_path);
+                });
+                stats.bytes_read += rows_of(I + 1) * ld * sizeof(float);
+            }
+
+            for (size_t x = 0; x < panels; ++x) {
+                const int J = (int) (I % 2 == 0 ? x : panels - 1 - x);
+                if (pending == J) {
+                    wait(read_b);
+                    have[pending_slot] = J;
+                    pending = -1;
+                }
+                int slot = have[0] == J ? 0 : have[1] == J ? 1 : -1;
+                if (slot < 0) { // 只有第一个列面板需要同步读入
+                    slot = 0;
+                    auto t0 = clock::now();
+                    read_rows(tf.fd, ht, J * P, rows_of(J), b[slot].get(), tmp_path);
+                    stats.io_wait_seconds += seconds_since(t0);
+                    stats.bytes_read += rows_of(J) * ld * sizeof(float);
+                    have[slot] = J;
+                }
+
+                // 预取下一个列面板到另一份缓冲区（行面板交界处它可能已经在那里了）
+                const int Jn = x + 1 < panels ? (int) (I % 2 == 0 ? x + 1 : panels - 2 - x) : -1;
+                if (Jn >= 0 && have[1 - slot] != Jn) {
+                    pending_slot = 1 - slot;
+                    pending = Jn;
+                    have[pending_slot] = -1;
+                    float *next = b[pending_slot].get();
+                    read_b = std::async(std::launch::async, [&, Jn, next] {
+                        read_rows(tf.fd, ht, Jn * P, rows_of(Jn), next, tmp_path);
+                    });
+                    stats.bytes_read += rows_of(Jn) * ld * sizeof(float);
+                }
+
+                auto t0 = clock::now();
+                {
+                    WorkspaceScope scope(&panel_ws);
+                    step_panel_dispatch(ci + J * P, ld, ai, ld, b[slot].get(), ld, rows_of(I), rows_of(J), n);
+                }
+                stats.compute_seconds += seconds_since(t0);
+            }
+
+            // 写回行面板 I；c[I % 2] 上一次使用是在行面板 I - 2，其写回在发起 I - 1 的写回之前已经完成
+            wait(write_c);
+            write_c = std::async(std::launch::async, [&, I, ci] {
+                write_rows(out.fd, hr, I * P, rows_of(I), ci, out_path);
+            });
+            stats.bytes_written += rows_of(I) * ld * sizeof(float);
+        }
+        wait(write_c);
+    } catch (...) {
+        // 先等后台线程结束，它们引用了本函数中的缓冲区
+        for (auto *f: {&read_a, &read_b, &write_c})
+            if (f->valid())
+                f->wait();
+        std::remove(tmp_path.c_str());
+        throw;
+    }
+    std::remove(tmp_path.c_str());
+    return stats;
+}
+
+#endif
+
+#endif //OUTOFCORE_H
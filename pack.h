@@ -0,0 +1,171 @@
+/**
+ * 打包阶段：把 d 复制 / 转置成内核需要的补齐布局（转置副本 t、vd / vt、SimdPlan 的 pd / pt 等）
+ * 原来各内核自己写两重循环：转置时按列读 d（每个元素跨一整行），打包时逐个 lane 插入并判断 j < n，
+ * n = 16000 时单是这一步就要几秒。这里统一为：
+ * 1. pack_cols（转置）：按 64×64 的块（16KB，读写都在 L1 内）划分，块内逐个 8×8 小块读入 8 行，
+ *    在寄存器中转置（四个 4×4 子块，各两轮 shuffle）后整行写出；块之间用 OpenMP 静态分配给各线程
+ * 2. pack_rows（复制）：整段 8 个 float 地复制；只有每行最后一段与 n 之后的补齐行需要填 inf
+ * 3. 只有跨过 n 的边缘小块走慢路径（先拷到局部数组、补 inf，再同样转置），内部小块没有任何分支
+ * 目标布局由 Layout 给出：layout(i, k) 为第 i 行第 k 个元素（k 为 8 的倍数）开始的 8 个连续 float 的地址，
+ * 按行存放（RowLayout）与 v7 的 3 行交错（GroupedLayout）都可表示。
+ * 每行只写 [0, width) 列：width 可以等于 n（转置副本 t，不碰行距的补齐部分），也可以是补齐后的长度（列 >= n 的部分为 inf）；
+ * 补齐用的值 fill 默认为 inf（min-plus），其他半环用各自的单位元（semiring.h）
+ *
+ * 这些函数不带 target 属性，在 dispatch.h 的各指令集版本中直接调用；这一阶段受访存限制，128 位的 shuffle 已经足够。
+ * 吞吐量见 ./bench --pack。
+ */
+
+#ifndef PACK_H
+#define PACK_H
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+namespace pack_detail {
+    // 8 个 float 的一行按两个 128 位向量存放：不开 AVX 编译时，256 位向量的通用 shuffle 会被拆成逐个元素的操作
+    typedef float f4 __attribute__ ((vector_size(4 * sizeof(float))));
+    typedef int i4 __attribute__ ((vector_size(4 * sizeof(int))));
+    typedef f4 row8[2];
+
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    constexpr size_t tile = 64;  // 64×64 个 float 为一块
+
+    // 不要求对齐的 128 位读写（movups）
+    typedef float f4u __attribute__ ((vector_size(4 * sizeof(float)), aligned(sizeof(float))));
+
+    inline void load(row8 &r, const float *p) {
+        r[0] = *reinterpret_cast<const f4u *>(p);
+        r[1] = *reinterpret_cast<const f4u *>(p + 4);
+    }
+
+    inline void store(float *p, const row8 &r) {
+        *reinterpret_cast<f4u *>(p) = r[0];
+        *reinterpret_cast<f4u *>(p + 4) = r[1];
+    }
+
+    // 4×4 转置（unpcklps / unpckhps / movlhps / movhlps）
+    inline void transpose4(f4 &a, f4 &b, f4 &c, f4 &d) {
+        const f4 t0 = __builtin_shuffle(a, b, i4{0, 4, 1, 5}), t1 = __builtin_shuffle(a, b, i4{2, 6, 3, 7});
+        const f4 t2 = __builtin_shuffle(c, d, i4{0, 4, 1, 5}), t3 = __builtin_shuffle(c, d, i4{2, 6, 3, 7});
+        a = __builtin_shuffle(t0, t2, i4{0, 1, 4, 5});
+        b = __builtin_shuffle(t0, t2, i4{2, 3, 6, 7});
+        c = __builtin_shuffle(t1, t3, i4{0, 1, 4, 5});
+        d = __builtin_shuffle(t1, t3, i4{2, 3, 6, 7});
+    }
+
+    // 8×8 转置：四个 4×4 子块各自转置，再交换右上与左下两块
+    inline void transpose8(row8 (&r)[8]) {
+        for (int a = 0; a < 8; a += 4)
+            for (int h = 0; h < 2; ++h)
+                transpose4(r[a][h], r[a + 1][h], r[a + 2][h], r[a + 3][h]);
+        for (int a = 0; a < 4; ++a)
+            std::swap(r[a][1], r[a + 4][0]);
+    }
+}
+
+// 按行存放：第 i 行从 p + i * stride 开始
+struct RowLayout {
+    float *p;
+    size_t stride;
+
+    float *operator()(const size_t i, const size_t k) const {
+        return p + i * stride + k;
+    }
+};
+
+// group 行交错存放（v7）：第 i / group 组的第 k / 8 个向量中，组内 group 行相邻
+struct GroupedLayout {
+    float *p;
+    size_t blocks, group;
+
+    float *operator()(const size_t i, const size_t k) const {
+        return p + ((i / group * blocks + k / 8) * group + i % group) * 8;
+    }
+};
+
+/* dst 的第 i 行 = src（src_rows×src_cols，行距 lds）的第 i 行，i < rows，每行写 [0, width) 列
+ * i >= src_rows 或列 >= src_cols 的部分为 fill
+ */
+template <typename Layout>
+void pack_rows(const Layout &dst, const size_t rows, const size_t width, const float *src, const size_t src_rows,
+               const size_t src_cols, const size_t lds, const float fill = pack_detail::inf) {
+    using namespace pack_detail;
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t k = 0; k < width; k += 8) {
+            const size_t w = std::min<size_t>(8, width - k);
+            float *x = dst(i, k);
+            if (i < src_rows && k + 8 <= src_cols && w == 8) {
+                row8 v;
+                load(v, src + lds * i + k);
+                store(x, v);
+                continue;
+            }
+            for (size_t v = 0; v < w; ++v)
+                x[v] = i < src_rows && k + v < src_cols ? src[lds * i + k + v] : fill;
+        }
+    }
+}
+
+namespace pack_detail {
+    // 跨过边界的 8×8 小块：越界部分补 inf 后同样转置，只写 dst 中 j < rows、k < width 的部分
+    template <typename Layout>
+    __attribute__((noinline)) void pack_cols_edge(const Layout &dst, const size_t rows, const size_t width,
+                                                  const float *src, const size_t src_rows, const size_t src_cols,
+                                                  const size_t lds, const size_t j0, const size_t k0, const float fill) {
+        row8 r[8];
+        for (size_t a = 0; a < 8; ++a)
+            for (size_t b = 0; b < 8; ++b)
+                r[a][b / 4][b % 4] = k0 + a < src_rows && j0 + b < src_cols ? src[lds * (k0 + a) + j0 + b] : fill;
+        transpose8(r);
+        const size_t w = std::min<size_t>(8, width - k0);
+        for (size_t b = 0; b < 8 && j0 + b < rows; ++b) {
+            float *y = dst(j0 + b, k0);
+            for (size_t v = 0; v < w; ++v)
+                y[v] = r[b][v / 4][v % 4];
+        }
+    }
+}
+
+/* dst 的第 j 行 = src（src_rows×src_cols，行距 lds）的第 j 列，j < rows，每行写 [0, width) 列
+ * 即 dst(j, k) = src[k][j]；j >= src_cols 或 k >= src_rows 的部分为 fill
+ */
+template <typename Layout>
+void pack_cols(const Layout &dst, const size_t rows, const size_t width, const float *src, const size_t src_rows,
+               const size_t src_cols, const size_t lds, const float fill = pack_detail::inf) {
+    using namespace pack_detail;
+    const size_t rt = (rows + tile - 1) / tile, kt = (width + tile - 1) / tile;
+    // 不越界的小块：j < full_rows 且 k < full_width
+    const size_t full_rows = std::min(rows, src_cols) / 8 * 8, full_width = std::min(width, src_rows) / 8 * 8;
+#pragma omp parallel for collapse(2) schedule(static)
+    for (size_t jt = 0; jt < rt; ++jt) {
+        for (size_t ktt = 0; ktt < kt; ++ktt) {
+            const size_t j1 = std::min(rows, jt * tile + tile), k1 = std::min(width, ktt * tile + tile);
+            // 块内 j 在外：写 dst 的 8 行时顺序写过 64 列，相邻的 j0 读 src 中同样的 64 行，仍在 L1 中
+            for (size_t j0 = jt * tile; j0 < j1; j0 += 8) {
+                for (size_t k0 = ktt * tile; k0 < k1; k0 += 8) {
+                    if (j0 >= full_rows || k0 >= full_width) {
+                        pack_cols_edge(dst, rows, width, src, src_rows, src_cols, lds, j0, k0, fill);
+                        continue;
+                    }
+                    row8 r[8];
+                    for (size_t a = 0; a < 8; ++a)
+                        load(r[a], src + lds * (k0 + a) + j0);
+                    transpose8(r);
+                    for (size_t b = 0; b < 8; ++b)
+                        store(dst(j0 + b, k0), r[b]);
+                }
+            }
+        }
+    }
+}
+
+// t = d 的转置（d、t 均为 n×n，行距分别为 ld、ldt），只写每行的前 n 列
+inline void transpose(float *t, const size_t ldt, const float *d, const size_t n, const size_t ld) {
+    pack_cols(RowLayout{t, ldt}, n, n, d, n, n, ld);
+}
+
+#endif //PACK_H
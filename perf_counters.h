@@ -0,0 +1,255 @@
+/**
+ * 硬件性能计数器（Linux perf_event_open），用于判断一个内核慢在哪里
+ * 只有墙钟时间时，某个版本变慢了无法区分是 cache 缺失、TLB 缺失还是 IPC 低；这里在每次运行前后读取：
+ *   cycles、instructions（两者之比即 IPC）、L1d 读缺失、LLC 缺失、dTLB 读缺失、后端停顿周期
+ * 1. 每个 OpenMP 线程各自打开一组计数器（pid = 0 即只统计该线程），因此可以按线程给出结果，用来发现负载不均；
+ *    libgomp 在线程数不变时复用同一批线程，同一个 PerfCounters 对象要在相同的线程数下使用
+ * 2. 只统计用户态（exclude_kernel），perf_event_paranoid <= 2 时普通用户即可使用
+ * 3. 各事件单独打开而不是作为一组：PMU 的计数器不够时内核会分时复用，读数按 time_enabled / time_running 放大
+ * 4. 某个事件打不开（CPU 不支持，如很多 Intel 处理器没有后端停顿事件）时只缺这一项；
+ *    全部打不开（容器或虚拟机中没有 PMU、权限不足、非 Linux）时 available() 为 false，调用者只报告墙钟时间
+ * 空闲的 OpenMP 线程在等待下一个并行区域时会自旋一段时间（GOMP_SPINCOUNT），这部分也会计入该线程的 cycles 与 instructions。
+ *
+ * 环境变量 PPC_PERF=off 可关闭计数器。
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+enum PerfEvent : size_t {
+    PerfCycles, PerfInstructions, PerfL1dMisses, PerfLlcMisses, PerfDtlbMisses, PerfStalledCycles, PerfEventCount
+};
+
+inline const char *perf_event_name(const size_t e) {
+    static const char *names[PerfEventCount] = {
+        "cycles", "instructions", "L1d-misses", "LLC-misses", "dTLB-misses", "stalled-cycles"
+    };
+    return names[e];
+}
+
+// 一次运行中各事件的计数；valid[e] 为 false 表示该事件不可用
+struct PerfCounts {
+    std::array<double, PerfEventCount> value{};
+    std::array<bool, PerfEventCount> valid{};
+
+    double ipc() const {
+        return valid[PerfCycles] && valid[PerfInstructions] && value[PerfCycles] > 0
+                   ? value[PerfInstructions] / value[PerfCycles]
+                   : 0;
+    }
+
+    PerfCounts &operator+=(const PerfCounts &o) {
+        for (size_t e = 0; e < PerfEventCount; ++e) {
+            value[e] += o.value[e];
+            valid[e] = valid[e] || o.valid[e];
+        }
+        return *this;
+    }
+
+    PerfCounts &operator/=(const double k) {
+        for (double &v: value)
+            v /= k;
+        return *this;
+    }
+};
+
+// 输出一行 "cycles 1.2e+09, instructions ..., IPC 2.10"，跳过不可用的事件
+inline void print_perf_counts(std::ostream &os, const PerfCounts &c) {
+    const std::ios::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+    os << std::setprecision(3);
+    bool first = true;
+    for (size_t e = 0; e < PerfEventCount; ++e) {
+        if (!c.valid[e])
+            continue;
+        os << (first ? "" : ", ") << perf_event_name(e) << ' ' << c.value[e];
+        first = false;
+    }
+    if (c.ipc() > 0)
+        os << ", IPC " << std::fixed << std::setprecision(2) << c.ipc();
+    os.flags(flags);
+    os.precision(precision);
+}
+
+namespace perf_detail {
+#ifdef __linux__
+    inline bool event_attr(const size_t e, perf_event_attr &attr) {
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        auto cache = [](uint64_t id) {
+            return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        switch (e) {
+            case PerfCycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                return true;
+            case PerfInstructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                return true;
+            case PerfL1dMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache(PERF_COUNT_HW_CACHE_L1D);
+                return true;
+            case PerfLlcMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                return true;
+            case PerfDtlbMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache(PERF_COUNT_HW_CACHE_DTLB);
+                return true;
+            case PerfStalledCycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND;
+                return true;
+            default:
+                return false;
+        }
+    }
+#endif
+
+    inline bool disabled_by_env() {
+        const char *env = std::getenv("PPC_PERF");
+        return env && std::strcmp(env, "off") == 0;
+    }
+}
+
+/* 每个 OpenMP 线程一组计数器：
+ *     PerfCounters pc;          // 在当前线程数下打开
+ *     pc.start(); kernel(); pc.stop();
+ *     pc.total(); pc.per_thread()[t];
+ */
+class PerfCounters {
+public:
+    explicit PerfCounters(int threads = 0) {
+#ifdef _OPENMP
+        if (threads <= 0)
+            threads = omp_get_max_threads();
+#else
+        threads = 1;
+#endif
+        fds.assign(threads, {});
+        for (auto &f: fds)
+            f.fill(-1);
+        counts.assign(threads, PerfCounts{});
+#ifdef __linux__
+        if (perf_detail::disabled_by_env())
+            return;
+#pragma omp parallel num_threads(threads)
+        {
+#ifdef _OPENMP
+            const int t = omp_get_thread_num();
+#else
+            const int t = 0;
+#endif
+            for (size_t e = 0; e < PerfEventCount; ++e) {
+                perf_event_attr attr;
+                if (perf_detail::event_attr(e, attr))
+                    fds[t][e] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (auto &f: fds)
+            for (int fd: f)
+                if (fd >= 0)
+                    close(fd);
+#endif
+    }
+
+    // 是否有任何一个计数器可用；为 false 时 start / stop 什么也不做
+    bool available() const {
+        for (auto &f: fds)
+            for (int fd: f)
+                if (fd >= 0)
+                    return true;
+        return false;
+    }
+
+    size_t threads() const {
+        return fds.size();
+    }
+
+    void start() {
+#ifdef __linux__
+        for (auto &f: fds)
+            for (int fd: f)
+                if (fd >= 0) {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (auto &f: fds)
+            for (int fd: f)
+                if (fd >= 0)
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (size_t t = 0; t < fds.size(); ++t) {
+            counts[t] = PerfCounts{};
+            for (size_t e = 0; e < PerfEventCount; ++e) {
+                uint64_t buf[3]; // value, time_enabled, time_running
+                if (fds[t][e] < 0 || read(fds[t][e], buf, sizeof(buf)) != (ssize_t) sizeof(buf))
+                    continue;
+                // time_enabled 为 0：该线程在这段时间里没有运行，计数为 0；启用了却从未被调度到 PMU 上则无法估计
+                if (buf[1] != 0 && buf[2] == 0)
+                    continue;
+                counts[t].value[e] = buf[1] == 0 ? 0 : (double) buf[0] * ((double) buf[1] / (double) buf[2]);
+                counts[t].valid[e] = true;
+            }
+        }
+#endif
+    }
+
+    // 最近一次 start / stop 之间各线程的计数
+    const std::vector<PerfCounts> &per_thread() const {
+        return counts;
+    }
+
+    PerfCounts total() const {
+        PerfCounts sum;
+        for (const PerfCounts &c: counts)
+            sum += c;
+        return sum;
+    }
+
+private:
+    std::vector<std::array<int, PerfEventCount>> fds;
+    std::vector<PerfCounts> counts;
+};
+
+#endif //PERF_COUNTERS_H
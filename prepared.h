@@ -0,0 +1,274 @@
+/**
+ * 预处理过的矩阵（prepared matrix）：把内核对 d 的预处理结果（转置副本 t、补齐打包的 vd / vt 等）留下来
+ * 各内核每次调用都要先做一遍 O(n^2) 的转置 / 打包，d 不变时这一步的结果其实每次都一样。
+ * 同一张图反复参与运算时（固定的 d 与许多其他矩阵相乘、或在服务中对同一个 d 反复调用），
+ * n 为几百到一两千时这部分开销占到总时间的百分之几到十几。PreparedMatrix 记住 d 的指针、n、ld，
+ * 并按“布局”（key）缓存每种内核需要的打包结果：
+ * 1. 内核中用 PackedOperand 代替 scratch_array 申请打包数组：当前线程有 PreparedMatrix（见 PreparedScope）
+ *    且它描述的正是这次的 d 时，直接取缓存中的数组；needs_build() 为真（第一次、或 d 已经改变）时才重新打包，打包后调用 built()
+ * 2. 布局相同的内核共享一份缓存，例如 step_trans / step_trans_omp / step_trans_ilp_omp 的转置副本，
+ *    v4 <3,3>、v5、v6 的 pack_simd 结果，step_simd_* 与 step_argmin_* 的 SimdPlan
+ * 3. 失效：Version 模式下调用者修改 d 之后必须调用 invalidate()（版本号加一）；Hash 模式下每次调用开始时
+ *    对 d 的 n×n 部分算一遍哈希（只读一遍 d，比打包便宜得多），与上次不同时自动失效
+ * 4. 缓存的数组按 huge_array 分配，由 PreparedMatrix 持有，析构或 clear() 时释放；不借用 Workspace
+ *
+ * 与 Workspace 相同，内核的签名（step_fn）不变：调用者用 PreparedScope 把 PreparedMatrix 设为当前线程的，
+ * 然后照常以 pm.data() 为 d 调用任意内核；d 不是 pm.data()（或 n、ld 不同）时内核照旧自行打包。
+ * 同一个 PreparedMatrix 同一时间只能被一次调用使用（否则抛出 std::logic_error）。
+ */
+
+#ifndef PREPARED_H
+#define PREPARED_H
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "hugepage.h"
+#include "workspace.h"
+
+class PreparedMatrix {
+public:
+    enum class Validation { Version, Hash };
+
+    /* d 为调用者持有的 n×n、行距为 ld 的矩阵，PreparedMatrix 只保存指针，不复制
+     * Version：d 改变后由调用者 invalidate()；Hash：每次使用前比较内容哈希
+     */
+    PreparedMatrix(const float *d, const size_t n, const size_t ld, const Validation mode = Validation::Version)
+        : d(d), n(n), ld(ld), mode(mode) {}
+
+    PreparedMatrix(const PreparedMatrix &) = delete;
+    PreparedMatrix &operator=(const PreparedMatrix &) = delete;
+
+    const float *data() const {
+        return d;
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    size_t get_ld() const {
+        return ld;
+    }
+
+    Validation validation() const {
+        return mode;
+    }
+
+    // d 的内容已改变：所有缓存的表示在下一次使用时重建
+    void invalidate() {
+        ++ver;
+    }
+
+    // 改为描述另一个矩阵（指针、规模或行距不同），释放所有缓存
+    void reset(const float *d, const size_t n, const size_t ld) {
+        this->d = d;
+        this->n = n;
+        this->ld = ld;
+        clear();
+        ++ver;
+        hashed = false;
+    }
+
+    // 释放所有缓存的表示
+    void clear() {
+        entries.clear();
+    }
+
+    uint64_t version() const {
+        return ver;
+    }
+
+    // 缓存占用的总字节数
+    size_t cached_bytes() const {
+        size_t total = 0;
+        for (const auto &e: entries)
+            total += e.second.bytes[0] + e.second.bytes[1];
+        return total;
+    }
+
+    // 累计（重新）构建表示的次数：d 不变时重复调用应保持不变
+    size_t builds() const {
+        return build_count;
+    }
+
+    // d 的 n×n 部分的哈希（不含补齐部分）：每行 FNV-1a，再按行号混合
+    uint64_t content_hash() const {
+        uint64_t h = 0;
+#pragma omp parallel for schedule(static) reduction(^ : h)
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t x = 14695981039346656037ull;
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(d + ld * i);
+            for (size_t b = 0; b < n * sizeof(float); ++b)
+                x = (x ^ p[b]) * 1099511628211ull;
+            h ^= (x ^ i) * 0x9e3779b97f4a7c15ull;
+        }
+        return h;
+    }
+
+private:
+    friend class PreparedScope;
+    friend class PackedOperand;
+
+    // 一种布局的缓存：至多两个数组（如 vd、vt），built 为构建时的版本号
+    struct Entry {
+        huge_ptr<char> buf[2]{{nullptr, huge_free}, {nullptr, huge_free}};
+        size_t bytes[2] = {0, 0};
+        uint64_t built = 0;
+        bool valid = false;
+    };
+
+    // Hash 模式下每次调用开始时检查内容是否改变
+    void refresh() {
+        if (mode != Validation::Hash)
+            return;
+        const uint64_t h = content_hash();
+        if (hashed && h != hash)
+            ++ver;
+        hash = h;
+        hashed = true;
+    }
+
+    // 取 key 对应的缓存，数组大小不同时重新分配
+    Entry &entry(const std::string &key, const size_t bytes0, const size_t bytes1) {
+        Entry &e = entries[key];
+        const size_t bytes[2] = {bytes0, bytes1};
+        for (int b = 0; b < 2; ++b) {
+            if (e.bytes[b] == bytes[b])
+                continue;
+            e.buf[b] = huge_array<char>(bytes[b]);
+            if (bytes[b] && !e.buf[b])
+                throw std::bad_alloc();
+            e.bytes[b] = bytes[b];
+            e.valid = false;
+        }
+        return e;
+    }
+
+    const float *d;
+    size_t n, ld;
+    Validation mode;
+    uint64_t ver = 0;
+    uint64_t hash = 0;
+    bool hashed = false;
+    size_t build_count = 0;
+    std::map<std::string, Entry> entries;
+    std::atomic<bool> in_use{false};
+};
+
+// 当前线程的预处理矩阵，为空表示内核自行打包
+inline PreparedMatrix *&current_prepared() {
+    thread_local PreparedMatrix *pm = nullptr;
+    return pm;
+}
+
+/* 在作用域内把 pm 设为当前线程的预处理矩阵（pm 为空时即不使用），离开时恢复原来的
+ *     PreparedMatrix pm(d, n, ld);       // 在多次调用之间保留
+ *     for (...) {
+ *         PreparedScope scope(&pm);
+ *         kernel(r, pm.data(), n, ld);
+ *     }
+ */
+class PreparedScope {
+public:
+    explicit PreparedScope(PreparedMatrix *pm) : pm(pm), saved(current_prepared()) {
+        if (pm) {
+            if (pm->in_use.exchange(true))
+                throw std::logic_error("prepared matrix is already in use by another call");
+            try {
+                pm->refresh();
+            } catch (...) {
+                pm->in_use = false;
+                throw;
+            }
+        }
+        current_prepared() = pm;
+    }
+
+    PreparedScope(const PreparedScope &) = delete;
+    PreparedScope &operator=(const PreparedScope &) = delete;
+
+    ~PreparedScope() {
+        current_prepared() = saved;
+        if (pm)
+            pm->in_use = false;
+    }
+
+private:
+    PreparedMatrix *pm;
+    PreparedMatrix *saved;
+};
+
+/* 内核中 d 的打包数组（至多两个，bytes1 为 0 时只有一个）：
+ *     PackedOperand op("transpose", d, n, ld, n * ld * sizeof(float));
+ *     float *t = op.get<float>(0);
+ *     if (op.needs_build()) {
+ *         ... 填充 t ...
+ *         op.built();
+ *     }
+ * 当前的 PreparedMatrix 描述的正是 (d, n, ld) 时使用其中 key 对应的缓存，已是最新时 needs_build() 为假；
+ * 否则同 scratch_array，每次都需要构建。key 标识布局：布局相同（数组大小也相同）的内核可以共享，
+ * 布局不同的内核必须用不同的 key。key 为空时总是不缓存；两种情况下分配失败都抛出 std::bad_alloc
+ * 打包代码直接写在内核里（而不是传入回调）：dispatch.h 中带 target 属性的函数里，lambda 不继承 target 属性
+ */
+class PackedOperand {
+public:
+    PackedOperand(const char *key, const float *d, const size_t n, const size_t ld,
+                  const size_t bytes0, const size_t bytes1 = 0) {
+        PreparedMatrix *pm = current_prepared();
+        if (key && pm && pm->data() == d && pm->size() == n && pm->get_ld() == ld) {
+            entry = &pm->entry(key, bytes0, bytes1);
+            version = pm->version();
+            owner = pm;
+            p[0] = entry->buf[0].get();
+            p[1] = entry->buf[1].get();
+            stale = !entry->valid || entry->built != version;
+        } else {
+            own[0] = scratch_array<char>(bytes0);
+            if (bytes1)
+                own[1] = scratch_array<char>(bytes1);
+            if ((bytes0 && !own[0]) || (bytes1 && !own[1]))
+                throw std::bad_alloc();
+            p[0] = own[0].get();
+            p[1] = own[1].get();
+        }
+    }
+
+    PackedOperand(const PackedOperand &) = delete;
+    PackedOperand &operator=(const PackedOperand &) = delete;
+
+    template <typename T>
+    T *get(const size_t i) const {
+        return reinterpret_cast<T *>(p[i]);
+    }
+
+    // 需要（重新）打包
+    bool needs_build() const {
+        return stale;
+    }
+
+    // 打包完成，缓存中的表示对应当前版本
+    void built() {
+        if (entry && stale) {
+            entry->built = version;
+            entry->valid = true;
+            ++owner->build_count;
+        }
+        stale = false;
+    }
+
+private:
+    huge_ptr<char> own[2]{{nullptr, huge_free}, {nullptr, huge_free}};
+    void *p[2] = {nullptr, nullptr};
+    PreparedMatrix::Entry *entry = nullptr;
+    PreparedMatrix *owner = nullptr;
+    uint64_t version = 0;
+    bool stale = true;
+};
+
+#endif //PREPARED_H
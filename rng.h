@@ -0,0 +1,74 @@
+/**
+ * 可并行、可复现的随机矩阵生成
+ * 原来的 create() / Matrix(n, 0.f, true) 用 random_device 给 mt19937 取种子，逐个元素生成再调用 std::round：
+ * 1. mt19937 有内部状态，只能串行生成，n = 16000 时生成输入比要测的内核还慢
+ * 2. 每次运行的输入都不同，无法复现某一次的结果
+ * 这里改为 counter-based 的生成方式：元素 (i, j) 的值只由 (seed, i, j) 决定，与其他元素无关，
+ * 因此可以按行任意并行、行内向量化，且无论多少线程、行距 ld 是多少，同一个 seed 得到的矩阵都逐位相同。
+ * - 行密钥：splitmix64(seed, i)，64 位，每行算一次
+ * - 元素：以行密钥的低、高 32 位为密钥，对列号 j 做两轮 32 位混合（lowbias32），只用 32 位乘法和移位，GCC 可自动向量化
+ * 分布与原来相同：对角线为 0，其余为 [1, 20) 上的均匀分布保留两位小数；
+ * 四舍五入改用整数运算：32 位均匀整数 t 映射到 100 + round(1900 * t / 2^32) 分，即 x = 1 + 19u 的 round(100x)。
+ *
+ * 默认种子为固定值 default_seed，每次运行输入相同；环境变量 PPC_SEED 可指定其他种子（十进制或 0x 开头的十六进制）。
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+
+constexpr uint64_t default_seed = 0x9e3779b97f4a7c15ull;
+
+// splitmix64 的输出函数：第 counter 个输出，state = seed + (counter + 1) * golden
+inline uint64_t splitmix64(uint64_t seed, uint64_t counter) {
+    uint64_t z = seed + (counter + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// lowbias32：32 位整数的混合函数
+inline uint32_t mix32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// 本次运行使用的种子：PPC_SEED，未设置时为 default_seed
+inline uint64_t random_seed() {
+    static const uint64_t seed = [] {
+        const char *env = std::getenv("PPC_SEED");
+        return env ? std::strtoull(env, nullptr, 0) : default_seed;
+    }();
+    return seed;
+}
+
+/* 第 i 行的 cols 个元素写入 row[0..cols)，对角线（j == i）为 0
+ * 其余元素为 [1, 20) 上保留两位小数的均匀分布
+ */
+inline void random_row(float *row, const size_t i, const size_t cols, const uint64_t seed) {
+    const uint64_t key = splitmix64(seed, i);
+    const uint32_t k0 = (uint32_t) key, k1 = (uint32_t) (key >> 32);
+    for (size_t j = 0; j < cols; ++j) {
+        const uint32_t t = mix32(mix32((uint32_t) j + k0) ^ k1);
+        const uint32_t cents = 100 + (uint32_t) ((1900ull * t + (1ull << 31)) >> 32);
+        row[j] = (float) cents / 100.f;
+    }
+    if (i < cols)
+        row[i] = 0.f;
+}
+
+// n×n（行距 ld）的随机矩阵，按行并行；结果只取决于 seed
+inline void fill_random(float *d, const size_t n, const size_t ld, const uint64_t seed = random_seed()) {
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i)
+        random_row(d + ld * i, i, n, seed);
+}
+
+#endif //RNG_H
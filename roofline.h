@@ -0,0 +1,207 @@
+/**
+ * Roofline 标定：测量本机（当前线程数下）的两个上限，用来判断一个内核离机器的极限还有多远
+ * 1. 计算上限 peak_gops：min-plus 的“乘加”是一次加法加一次取 min，这里让每个线程在寄存器中反复做 acc = min(acc + x, y)，
+ *    acc 之间互相独立、个数足够覆盖加法和 min 的延迟，只受这两种指令吞吐量的限制；每个 lane 每次计 2 个运算。
+ *    与 dispatch.h 一样按 selected_isa() 选择 4 / 8 / 16 lane 的版本，因此是“当前分派级别下”的上限
+ * 2. 带宽上限：STREAM 风格的 copy（a = b）和 triad（a = b + s * c），按 STREAM 的约定只计读写的数组字节数（不计写分配），
+ *    每种取 reps 次中最快的一次；以 triad 作为带宽上限。数组按 schedule(static) 首次写入，NUMA 模式下页在各线程本地。
+ *    每个数组默认取 4 倍 LLC 大小（至少 64 MB，至多物理内存的 1/16），环境变量 PPC_STREAM_MB 可指定；
+ *    数组比 LLC 小时测到的是 cache 带宽，会给出提示
+ *
+ * 对一个内核（n×n 的 min-plus，有用运算 2n^3）：
+ * - 算术强度 AI = 运算次数 / 必须的访存量 2 * n^2 * 4 字节 = n / 4（op/B）
+ * - roof = min(peak_gops, AI * bandwidth)，达到 roof 的比例即该内核的效率；
+ *   AI * bandwidth < peak_gops 时受带宽限制，否则受计算限制
+ * - 硬件计数器可用时另外用 LLC 缺失数 × 64 字节估计实际访存量，给出实测 AI，它远小于 n / 4 说明分块没有起作用
+ */
+
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include <unistd.h>
+
+#include "dispatch.h"
+#include "hugepage.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+struct RooflineCalibration {
+    int threads = 1;
+    SimdIsa isa = SimdIsa::SSE;
+    double peak_gops = 0;  // min + add，每秒 10^9 次
+    double copy_gbps = 0;  // STREAM copy
+    double triad_gbps = 0; // STREAM triad，作为带宽上限
+    size_t stream_bytes = 0; // 每个数组的字节数
+
+    double bandwidth() const {
+        return triad_gbps;
+    }
+
+    // 算术强度为 ai（op/B）时可达到的上限，GOP/s
+    double roof(const double ai) const {
+        return std::min(peak_gops, ai * bandwidth());
+    }
+};
+
+namespace roofline_detail {
+    constexpr size_t peak_acc = 12; // 独立累加器个数：加法和 min 的延迟约 4 个周期，每周期 2 条，12 个足够
+    constexpr size_t peak_iters = 1 << 22;
+
+    // 单个线程的计算峰值循环，返回一个依赖于所有累加器的值，防止被优化掉
+    template <size_t L>
+    PPC_INLINE float peak_loop(const size_t iters, const float seed) {
+        typedef floatv_t<L> V;
+        V acc[peak_acc], cap[peak_acc];
+        const V x = V{} + seed;
+        for (size_t a = 0; a < peak_acc; ++a) {
+            acc[a] = V{};
+            cap[a] = V{} + (float) (1000 + a);
+        }
+        for (size_t it = 0; it < iters; ++it) {
+            for (size_t a = 0; a < peak_acc; ++a) {
+                const V s = acc[a] + x;
+                acc[a] = s < cap[a] ? s : cap[a];
+            }
+        }
+        float sink = 0;
+        for (size_t a = 0; a < peak_acc; ++a)
+            for (size_t l = 0; l < L; ++l)
+                sink += acc[a][l];
+        return sink;
+    }
+
+    // 与 dispatch.h 相同：#pragma omp 写在带 target 属性的函数中
+#define PPC_PEAK_BODY(L)                                   \
+    float sink = 0;                                        \
+    _Pragma("omp parallel reduction(+:sink)")              \
+    sink += peak_loop<L>(iters, 0.5f);                     \
+    return sink;
+
+    inline float peak_sse(const size_t iters) {
+        PPC_PEAK_BODY(4)
+    }
+
+#ifdef PPC_HAVE_X86_DISPATCH
+    __attribute__((target("avx2,fma")))
+    inline float peak_avx2(const size_t iters) {
+        PPC_PEAK_BODY(8)
+    }
+
+    __attribute__((target("avx512f")))
+    inline float peak_avx512(const size_t iters) {
+        PPC_PEAK_BODY(16)
+    }
+#endif
+
+    inline size_t isa_lanes(const SimdIsa isa) {
+        return isa == SimdIsa::AVX512 ? 16 : isa == SimdIsa::AVX2 ? 8 : 4;
+    }
+
+    inline float run_peak(const SimdIsa isa, const size_t iters) {
+#ifdef PPC_HAVE_X86_DISPATCH
+        if (isa == SimdIsa::AVX512)
+            return peak_avx512(iters);
+        if (isa == SimdIsa::AVX2)
+            return peak_avx2(iters);
+#endif
+        return peak_sse(iters);
+    }
+
+    template <typename F>
+    inline double best_seconds(F &&f, const int reps) {
+        double best = 1e30;
+        for (int i = 0; i < reps; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            f();
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    inline size_t llc_bytes() {
+#ifdef _SC_LEVEL3_CACHE_SIZE
+        const long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if (l3 > 0)
+            return (size_t) l3;
+#endif
+        return 32ull << 20;
+    }
+
+    // 每个 STREAM 数组的字节数
+    inline size_t stream_bytes() {
+        if (const char *env = std::getenv("PPC_STREAM_MB"))
+            return std::max<size_t>(1, std::strtoull(env, nullptr, 0)) << 20;
+        const size_t phys = (size_t) sysconf(_SC_PHYS_PAGES) * (size_t) sysconf(_SC_PAGE_SIZE);
+        return std::max<size_t>(64ull << 20, std::min(4 * llc_bytes(), phys / 16));
+    }
+}
+
+// 在当前的 OpenMP 线程数和 selected_isa() 下标定，耗时约一两秒
+inline RooflineCalibration calibrate_roofline(const int reps = 5) {
+    using namespace roofline_detail;
+    RooflineCalibration cal;
+    cal.isa = selected_isa();
+#ifdef _OPENMP
+    cal.threads = omp_get_max_threads();
+#endif
+
+    volatile float sink = run_peak(cal.isa, 2 * peak_iters); // 预热，让频率升上来
+    const double t = best_seconds([&] { sink = run_peak(cal.isa, peak_iters); }, reps);
+    (void) sink;
+    cal.peak_gops = 2.0 * peak_acc * isa_lanes(cal.isa) * peak_iters * cal.threads / t * 1e-9;
+
+    cal.stream_bytes = stream_bytes();
+    const size_t count = cal.stream_bytes / sizeof(float);
+    auto a = huge_array<float>(count), b = huge_array<float>(count), c = huge_array<float>(count);
+    if (count && (!a || !b || !c))
+        throw std::bad_alloc();
+    float *pa = a.get(), *pb = b.get(), *pc = c.get();
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < count; ++i) {
+        pa[i] = 0.f;
+        pb[i] = 1.f;
+        pc[i] = 2.f;
+    }
+    const double t_copy = best_seconds([&] {
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < count; ++i)
+            pa[i] = pb[i];
+    }, reps);
+    const double t_triad = best_seconds([&] {
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < count; ++i)
+            pa[i] = pb[i] + 3.f * pc[i];
+    }, reps);
+    cal.copy_gbps = 2.0 * cal.stream_bytes / t_copy * 1e-9;
+    cal.triad_gbps = 3.0 * cal.stream_bytes / t_triad * 1e-9;
+    return cal;
+}
+
+inline void print_calibration(const RooflineCalibration &cal, std::ostream &os = std::cout) {
+    const std::ios::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(2);
+    os << "roofline (" << cal.threads << " threads, " << isa_name(cal.isa) << "): peak min+add "
+       << cal.peak_gops << " GOP/s, STREAM copy " << cal.copy_gbps << " GB/s, triad " << cal.triad_gbps
+       << " GB/s (" << (cal.stream_bytes >> 20) << " MB arrays), ridge point "
+       << cal.peak_gops / cal.bandwidth() << " op/B\n";
+    if (cal.stream_bytes < roofline_detail::llc_bytes())
+        os << "  note: STREAM arrays are smaller than the LLC (" << (roofline_detail::llc_bytes() >> 20)
+           << " MB), bandwidth is cache bandwidth\n";
+    os.flags(flags);
+    os.precision(precision);
+}
+
+#pragma GCC diagnostic pop
+
+#endif //ROOFLINE_H
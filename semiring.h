@@ -0,0 +1,93 @@
+/**
+ * 半环（semiring）：r[i][j] = ⊕_k d[i][k] ⊗ d[k][j]
+ * min-plus 只是其中之一，同样的分块 / 向量化内核（dispatch.h 中的 SimdPlan）换一组运算即可用于其他路径问题：
+ *     semiring   ⊗（combine）  ⊕（reduce）  单位元 zero   用途
+ *     MinPlus    x + y         min          +inf          最短路径（原来的 step）
+ *     MaxPlus    x + y         max          -inf          DAG 上的最长路径（没有边为 -inf，输入中不能有 +inf）
+ *     MaxMin     min(x, y)     max          -inf          最宽路径（瓶颈路径），边权为容量
+ *     OrAnd      and = min     or = max     0             可达性，输入只能是 0 / 1
+ * zero 是 ⊕ 的单位元、⊗ 的零元，打包时的补齐部分填 zero，不影响结果。
+ * 策略类的 combine / reduce 同时用于 float 和 GCC 向量类型（比较与 ?: 对向量逐 lane 进行），
+ * 作为模板参数在编译期展开，内层循环中没有任何运行时分派。
+ * MinPlus::reduce 写成 a > b ? b : a，与原来的 vv = vv > z ? z : vv 逐位相同。
+ */
+
+#ifndef SEMIRING_H
+#define SEMIRING_H
+
+#pragma once
+#include <cstddef>
+#include <limits>
+
+struct MinPlus {
+    static constexpr const char *name = "min_plus";
+    static constexpr float zero = std::numeric_limits<float>::infinity();
+
+    template <typename T>
+    static T combine(const T x, const T y) { return x + y; }
+
+    template <typename T>
+    static T reduce(const T a, const T b) { return a > b ? b : a; }
+};
+
+struct MaxPlus {
+    static constexpr const char *name = "max_plus";
+    static constexpr float zero = -std::numeric_limits<float>::infinity();
+
+    template <typename T>
+    static T combine(const T x, const T y) { return x + y; }
+
+    template <typename T>
+    static T reduce(const T a, const T b) { return a < b ? b : a; }
+};
+
+struct MaxMin {
+    static constexpr const char *name = "max_min";
+    static constexpr float zero = -std::numeric_limits<float>::infinity();
+
+    template <typename T>
+    static T combine(const T x, const T y) { return x > y ? y : x; }
+
+    template <typename T>
+    static T reduce(const T a, const T b) { return a < b ? b : a; }
+};
+
+// 布尔半环，用 0.f / 1.f 表示 false / true
+struct OrAnd {
+    static constexpr const char *name = "or_and";
+    static constexpr float zero = 0.f;
+
+    template <typename T>
+    static T combine(const T x, const T y) { return x > y ? y : x; }
+
+    template <typename T>
+    static T reduce(const T a, const T b) { return a < b ? b : a; }
+};
+
+// 运行时选择半环（公开接口 StepOptions::semiring）；内核按策略类实例化，只在入口处 switch 一次
+enum class SemiringKind { MinPlus, MaxPlus, MaxMin, OrAnd };
+
+inline const char *semiring_name(const SemiringKind k) {
+    switch (k) {
+        case SemiringKind::MaxPlus: return MaxPlus::name;
+        case SemiringKind::MaxMin: return MaxMin::name;
+        case SemiringKind::OrAnd: return OrAnd::name;
+        default: return MinPlus::name;
+    }
+}
+
+// 标量的参考实现（同 v0 的 step），用于校验
+template <typename S>
+void step_semiring_ref(float *r, const float *d, const size_t n, const size_t ld) {
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            float v = S::zero;
+            for (size_t k = 0; k < n; ++k)
+                v = S::reduce(v, S::combine(d[ld * i + k], d[ld * k + j]));
+            r[ld * i + j] = v;
+        }
+    }
+}
+
+#endif //SEMIRING_H
@@ -9,11 +9,12 @@
 
 #include <algorithm>
 #include <cstring>
-#include <random>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 
+#include "rng.h"
+
 void create(float *d, size_t n);
 
 void print(const float *mat, const size_t n);
@@ -49,27 +50,9 @@ int main() {
 	delete []d;
 }
 
+// [1, 20) 上保留两位小数、对角线为 0 的随机矩阵，按行并行生成，由 PPC_SEED 决定（见 rng.h）
 void create(float *d, const size_t n) {
-	// 创建随机数生成器
-	std::random_device rd; // 用于生成种子
-	std::mt19937 gen(rd()); // 随机数引擎使用 Mersenne Twister 算法
-
-	// 创建均匀分布 [1.0, 20.0)
-	std::uniform_real_distribution<> dis(1.0, 20.0);
-
-	// 生成随机浮点数并保留两位小数
-	for (size_t i = 0; i < n; ++i) {
-		for (size_t j = 0; j < n; ++j) {
-			if (i == j) {
-				d[i * n + j] = 0.0f; // 对角线元素设为 0
-			} else {
-				float random_value = dis(gen);
-				// 保留两位小数
-				float rounded_value = std::round(random_value * 100.0) / 100.0;
-				d[i * n + j] = rounded_value;
-			}
-		}
-	}
+	fill_random(d, n, n);
 }
 
 
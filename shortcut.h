@@ -0,0 +1,66 @@
+/**
+ * shortcut 库的公开接口（libshortcut，CMake 目标 shortcut）
+ * 在进程内计算一步 min-plus 乘积 r[i][j] = min_k d[i][k] + d[k][j]，不需要启动 bench 或其他可执行文件：
+ *
+ *     #include "shortcut.h"
+ *     StepOptions opt;
+ *     opt.kernel = "step_trans_simd_omp"; // 为空时用 step_simd_dispatch（按 CPU 选最快的版本）
+ *     opt.threads = 8;                    // 0 表示 OpenMP 的默认线程数
+ *     shortcut_step(r, d, n, ld, opt);
+ *
+ * 1. d、r 由调用者分配并持有，均为 n×n、行距为 ld（>= n）的按行存放的 float 矩阵，库不复制、不保留指针；
+ *    只读写每行的前 n 列，补齐部分不会被访问。行距取 64 字节的倍数（且不为 4KB 的倍数）时最快，见 Matrix::padded_ld
+ * 2. r 与 d 不能重叠（内核边读 d 边写 r）
+ * 3. 可用的内核名与 ./bench --list 相同（step、step_trans、step_trans_ilp_omp、step_trans_simd_omp、...），
+ *    shortcut_kernels() 返回当前 CPU 上可运行的那些
+ * 4. 出错时抛出异常：参数不合法或内核名未知为 std::invalid_argument，当前 CPU 不支持该内核为 std::runtime_error；
+ *    内核内部分配临时数组失败时为 std::bad_alloc
+ * 5. threads 只在本次调用中生效，返回前恢复调用线程原来的 OpenMP 线程数；不同线程可以同时调用
+ * 6. workspace 不为空时，内核的临时数组（转置副本、打包的 vd / vt 等）从中借用，调用结束后留在工作区里给下一次用；
+ *    同样大小的输入反复调用时，第一次之后不再分配内存。一个 Workspace 同一时间只能被一次调用使用：
+ *        Workspace ws;
+ *        opt.workspace = &ws;
+ *        for (...) shortcut_step(r, d, n, ld, opt);
+ * 7. 同一个 d 反复参与运算时，用 PreparedMatrix 代替 d：内核对 d 的转置 / 补齐打包结果留在其中，
+ *    d 不变时之后的调用直接使用（见 prepared.h）。修改 d 之后调用 invalidate()，或构造时选择 Hash 模式由库自行检测：
+ *        PreparedMatrix pd(d, n, ld);
+ *        for (...) shortcut_step(r, pd, opt);
+ *        ... 修改 d ...
+ *        pd.invalidate();
+ * 8. semiring 选择半环（semiring.h）：MinPlus（默认，最短路径）、MaxPlus（DAG 最长路径）、MaxMin（最宽路径）、
+ *    OrAnd（可达性，元素为 0 / 1）。非 MinPlus 时只能用默认内核（kernel 为空），由 step_semiring_dispatch 按 CPU 选择版本
+ *
+ * 这个头文件只依赖标准库、semiring.h、prepared.h 和 workspace.h（后两者只依赖 hugepage.h），不会引入内核的实现细节（dispatch.h、simd.h 等）。
+ * 内核通过静态对象注册，链接静态库 libshortcut.a 时需要 whole-archive：CMake 中 target_link_libraries(... shortcut) 已带上，
+ * 其他构建系统中用 -Wl,--whole-archive -lshortcut -Wl,--no-whole-archive，并加上 -fopenmp。
+ */
+
+#ifndef SHORTCUT_H
+#define SHORTCUT_H
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "prepared.h"
+#include "semiring.h"
+#include "workspace.h"
+
+struct StepOptions {
+    const char *kernel = nullptr;    // 内核名，为空（nullptr 或 ""）时为 step_simd_dispatch
+    int threads = 0;                 // OpenMP 线程数，0 表示默认
+    Workspace *workspace = nullptr;  // 内核临时数组的工作区，为空时每次调用自行分配
+    SemiringKind semiring = SemiringKind::MinPlus;  // 半环，非 MinPlus 时 kernel 须为空
+};
+
+// r = d ⊗ d（默认为 min-plus，见 StepOptions::semiring），d、r 为调用者持有的 n×n、行距为 ld 的矩阵
+void shortcut_step(float *r, const float *d, size_t n, size_t ld, const StepOptions &opt = StepOptions());
+
+// r = d ⊗ d，d 为预处理过的矩阵；d 的打包结果在多次调用之间复用
+void shortcut_step(float *r, PreparedMatrix &d, const StepOptions &opt = StepOptions());
+
+// 当前 CPU 上可以运行的内核名
+std::vector<std::string> shortcut_kernels();
+
+#endif //SHORTCUT_H
@@ -0,0 +1,98 @@
+/**
+ * shortcut.h 的实现：按名字在内核注册表（kernel_registry.h）中查找内核并调用；其他半环直接用 dispatch.h 中的实例
+ */
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "dispatch.h"
+#include "kernel_registry.h"
+#include "shortcut.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+    constexpr const char *default_kernel = "step_simd_dispatch";
+
+    // 在作用域内设置调用线程的 OpenMP 线程数，离开时恢复
+    class ThreadsScope {
+    public:
+        explicit ThreadsScope(const int threads) {
+#ifdef _OPENMP
+            saved = omp_get_max_threads();
+            if (threads > 0)
+                omp_set_num_threads(threads);
+#else
+            (void) threads;
+#endif
+        }
+
+        ~ThreadsScope() {
+#ifdef _OPENMP
+            omp_set_num_threads(saved);
+#endif
+        }
+
+        ThreadsScope(const ThreadsScope &) = delete;
+        ThreadsScope &operator=(const ThreadsScope &) = delete;
+
+    private:
+        int saved = 1;
+    };
+}
+
+void shortcut_step(float *r, const float *d, const size_t n, const size_t ld, const StepOptions &opt) {
+    step_fn fn;
+    if (opt.semiring == SemiringKind::MinPlus) {
+        const std::string name = opt.kernel && *opt.kernel ? opt.kernel : default_kernel;
+        const KernelInfo *k = find_kernel(name);
+        if (!k)
+            throw std::invalid_argument("shortcut_step: unknown kernel \"" + name + "\"");
+        if (!k->available())
+            throw std::runtime_error("shortcut_step: kernel \"" + name + "\" is not supported by this CPU");
+        fn = k->fn;
+    } else {
+        // 注册的内核都是 min-plus 的，其他半环只有分块内核的实例
+        if (opt.kernel && *opt.kernel)
+            throw std::invalid_argument(std::string("shortcut_step: semiring ") + semiring_name(opt.semiring) +
+                                        " only supports the default kernel");
+        fn = semiring_dispatch(opt.semiring);
+    }
+    if (opt.threads < 0)
+        throw std::invalid_argument("shortcut_step: threads must be >= 0");
+    if (n == 0)
+        return;
+    if (!r || !d)
+        throw std::invalid_argument("shortcut_step: null matrix");
+    if (ld < n)
+        throw std::invalid_argument("shortcut_step: ld (" + std::to_string(ld) + ") < n (" + std::to_string(n) + ")");
+    const uintptr_t pr = (uintptr_t) r, pd = (uintptr_t) d, span = ((n - 1) * ld + n) * sizeof(float);
+    if (pr < pd + span && pd < pr + span)
+        throw std::invalid_argument("shortcut_step: r and d overlap");
+
+    ThreadsScope scope(opt.threads);
+    WorkspaceScope workspace(opt.workspace);
+    fn(r, d, n, ld);
+}
+
+void shortcut_step(float *r, PreparedMatrix &d, const StepOptions &opt) {
+    // Hash 模式下 PreparedScope 构造时就要读 d，先检查；线程数也要先设好（哈希是并行计算的）
+    if (d.size() && !d.data())
+        throw std::invalid_argument("shortcut_step: null matrix");
+    if (d.get_ld() < d.size())
+        throw std::invalid_argument("shortcut_step: ld (" + std::to_string(d.get_ld()) + ") < n (" +
+                                    std::to_string(d.size()) + ")");
+    ThreadsScope scope(opt.threads);
+    PreparedScope prepared(&d);
+    shortcut_step(r, d.data(), d.size(), d.get_ld(), opt);
+}
+
+std::vector<std::string> shortcut_kernels() {
+    std::vector<std::string> names;
+    for (const KernelInfo &k: kernel_registry())
+        if (k.available())
+            names.push_back(k.name);
+    return names;
+}
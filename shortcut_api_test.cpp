@@ -0,0 +1,117 @@
+/**
+ * shortcut.h 的使用者测试：只链接 shortcut（INTERFACE 目标），只通过公开接口调用，ctest 运行
+ * 1. 当前 CPU 上可运行的每个内核（含默认内核）与参考实现 step（v0）逐位相同，行距分别为 n 与补齐
+ * 2. PreparedMatrix 重载：结果相同，d 修改并 invalidate() 之后结果随之更新
+ * 3. 参数不合法时抛出 std::invalid_argument：空指针、ld < n、r 与 d 重叠、未知内核名
+ * 有任何一项不通过时返回 1
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rng.h"
+#include "shortcut.h"
+
+namespace {
+    int failures = 0;
+
+    void expect(const bool ok, const std::string &what) {
+        if (!ok) {
+            std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    template <typename E>
+    void expect_throw(const std::function<void()> &fn, const std::string &what) {
+        try {
+            fn();
+        } catch (const E &) {
+            return;
+        } catch (const std::exception &e) {
+            expect(false, what + ": unexpected exception " + e.what());
+            return;
+        }
+        expect(false, what + ": no exception");
+    }
+
+    // 逐位比较前 n 列
+    bool same(const std::vector<float> &a, const std::vector<float> &b, const size_t n, const size_t ld) {
+        for (size_t i = 0; i < n; ++i)
+            if (std::memcmp(a.data() + ld * i, b.data() + ld * i, n * sizeof(float)) != 0)
+                return false;
+        return true;
+    }
+
+    StepOptions with_kernel(const char *kernel) {
+        StepOptions opt;
+        opt.kernel = kernel;
+        return opt;
+    }
+
+    void test_kernels(const size_t n, const size_t ld) {
+        std::vector<float> d(n * ld), ref(n * ld), r(n * ld);
+        fill_random(d.data(), n, ld, 1);
+        shortcut_step(ref.data(), d.data(), n, ld, with_kernel("step"));
+
+        const std::string tag = " (n = " + std::to_string(n) + ", ld = " + std::to_string(ld) + ")";
+        shortcut_step(r.data(), d.data(), n, ld);
+        expect(same(r, ref, n, ld), "default kernel" + tag);
+        for (const std::string &name: shortcut_kernels()) {
+            std::fill(r.begin(), r.end(), -1.f);
+            shortcut_step(r.data(), d.data(), n, ld, with_kernel(name.c_str()));
+            expect(same(r, ref, n, ld), name + tag);
+        }
+    }
+
+    void test_prepared(const size_t n, const size_t ld) {
+        std::vector<float> d(n * ld), ref(n * ld), r(n * ld);
+        fill_random(d.data(), n, ld, 2);
+        PreparedMatrix pd(d.data(), n, ld);
+        for (int round = 0; round < 2; ++round) {
+            shortcut_step(ref.data(), d.data(), n, ld, with_kernel("step"));
+            for (int call = 0; call < 2; ++call) {
+                std::fill(r.begin(), r.end(), -1.f);
+                shortcut_step(r.data(), pd);
+                expect(same(r, ref, n, ld), "PreparedMatrix round " + std::to_string(round) + " call " +
+                                                std::to_string(call));
+            }
+            d[ld * 1 + 2] = 0.5f;
+            pd.invalidate();
+        }
+
+        PreparedMatrix null_pd(nullptr, n, ld), narrow_pd(d.data(), n, n - 1);
+        expect_throw<std::invalid_argument>([&] { shortcut_step(r.data(), null_pd); }, "PreparedMatrix null d");
+        expect_throw<std::invalid_argument>([&] { shortcut_step(r.data(), narrow_pd); }, "PreparedMatrix ld < n");
+    }
+
+    void test_errors(const size_t n, const size_t ld) {
+        std::vector<float> d(n * ld), r(n * ld), both(2 * n * ld);
+        fill_random(d.data(), n, ld, 3);
+        expect_throw<std::invalid_argument>([&] { shortcut_step(nullptr, d.data(), n, ld); }, "null r");
+        expect_throw<std::invalid_argument>([&] { shortcut_step(r.data(), nullptr, n, ld); }, "null d");
+        expect_throw<std::invalid_argument>([&] { shortcut_step(r.data(), d.data(), n, n - 1); }, "ld < n");
+        expect_throw<std::invalid_argument>([&] { shortcut_step(d.data(), d.data(), n, ld); }, "r == d");
+        expect_throw<std::invalid_argument>([&] { shortcut_step(both.data() + ld, both.data(), n, ld); },
+                                            "r overlaps d");
+        expect_throw<std::invalid_argument>(
+            [&] { shortcut_step(r.data(), d.data(), n, ld, with_kernel("no_such_kernel")); }, "unknown kernel");
+    }
+}
+
+int main() {
+    test_kernels(37, 37);
+    test_kernels(100, 112);
+    test_prepared(100, 112);
+    test_errors(50, 64);
+    if (failures)
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+    else
+        std::printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/
+ * The shortcut problem
+ * 多源最短路（见 apsp.h）
+ * 1. floyd_warshall 为标量版本（k 在最外层，这才是正确的循环顺序），仅用于小规模校验
+ * 2. apsp_floyd_warshall 为三阶段分块版本，阶段三 OpenMP 并行 + 向量化
+ * 3. apsp_squaring 反复调用 step_simd_dispatch 做 min-plus 平方，结果不再变化时提前结束
+ * 4. apsp_squaring_paths 同时输出路由表，check_paths 检查 expand_path 展开的每条路径的边权之和等于最短路长度
+ * 5. 带参数运行时（shortcut_apsp input.ppcm [output.ppcm]）只读映射输入文件（见 matfile.h），
+ *    对其求多源最短路，结果直接写进映射的输出文件
+ * 三者做加法的结合顺序不同（(a + b) + c 与 a + (b + c)），结果可能相差几个 ulp，因此按相对误差比较
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "apsp.h"
+#include "matrix.h"
+
+void floyd_warshall(float *r, const float *d, size_t n, size_t ld);
+
+bool check(const char *name, const float *expected, const float *actual, size_t n, size_t ld);
+
+bool check_paths(const float *d, const float *r, const int *next, size_t n, size_t ld);
+
+int main(int argc, char **argv) {
+    numa_pin_threads();
+    if (argc > 1) {
+        Matrix d = Matrix::open_file(argv[1]);
+        const size_t n = d.size();
+        // r 与 d 的行距须相同
+        Matrix r = argc > 2 ? Matrix::create_file(argv[2], n, d.get_ld()) : Matrix(n, 0.f, false, d.get_ld());
+        size_t rounds = 0;
+        measure_time("apsp_squaring", [&]() {
+            rounds = apsp_squaring(r.get_pdata(), d.get_pdata(), n, d.get_ld());
+        });
+        std::cout << argv[1] << ": n = " << n << ", converged after " << rounds << " rounds\n";
+        return 0;
+    }
+
+    // 校验：与标量 Floyd-Warshall 比较
+    for (size_t n: {1, 2, 7, 63, 64, 65, 130, 257}) {
+        Matrix d(n, 0.f, true);
+        Matrix r0(n), r1(n), r2(n), r3(n);
+        const size_t ld = d.get_ld();
+        std::vector<int> next(n * ld);
+        floyd_warshall(r0.get_pdata(), d.get_pdata(), n, ld);
+        apsp_floyd_warshall(r1.get_pdata(), d.get_pdata(), n, ld);
+        apsp_squaring(r2.get_pdata(), d.get_pdata(), n, ld);
+        apsp_squaring_paths(r3.get_pdata(), next.data(), d.get_pdata(), n, ld);
+        if (!check("apsp_floyd_warshall", r0.get_pdata(), r1.get_pdata(), n, ld) ||
+            !check("apsp_squaring", r0.get_pdata(), r2.get_pdata(), n, ld) ||
+            !check("apsp_squaring_paths", r0.get_pdata(), r3.get_pdata(), n, ld) ||
+            !check_paths(d.get_pdata(), r3.get_pdata(), next.data(), n, ld))
+            return 1;
+    }
+
+    constexpr int n = 4000;
+
+    Matrix d(n, 0.f, true);
+    // d.print();
+
+    Matrix r(n);
+    // r.print();
+
+    measure_time("apsp_floyd_warshall", [&]() {
+        apsp_floyd_warshall(r.get_pdata(), d.get_pdata(), n, d.get_ld());
+    });
+    // r.print();
+
+    size_t rounds = 0;
+    measure_time("apsp_squaring", [&]() {
+        rounds = apsp_squaring(r.get_pdata(), d.get_pdata(), n, d.get_ld());
+    });
+    std::cout << "apsp_squaring converged after " << rounds << " rounds\n";
+    // r.print();
+
+    // 单次平方：求 argmin 的额外开销
+    std::vector<int> p(n * d.get_ld());
+    measure_time("step_simd_dispatch", [&]() {
+        step_simd_dispatch(r.get_pdata(), d.get_pdata(), n, d.get_ld());
+    });
+    measure_time("step_argmin_dispatch", [&]() {
+        step_argmin_dispatch(r.get_pdata(), p.data(), d.get_pdata(), n, d.get_ld());
+    });
+}
+
+bool check(const char *name, const float *expected, const float *actual, const size_t n, const size_t ld) {
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            float x = expected[ld * i + j], y = actual[ld * i + j];
+            if (std::fabs(x - y) > 1e-5f * std::fabs(x)) {
+                std::cout << name << " mismatch at n = " << n << ", i = " << i
+                          << ", j = " << j << ": " << x << " vs " << y << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool check_paths(const float *d, const float *r, const int *next, const size_t n, const size_t ld) {
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            std::vector<int> path = expand_path(next, n, ld, i, j);
+            float x = r[ld * i + j], y = path.empty() ? inf : 0.f;
+            for (size_t t = 0; t + 1 < path.size(); ++t)
+                y += d[ld * path[t] + path[t + 1]];
+            if (path.empty() != (x == inf) || (!path.empty() && path.back() != (int) j) ||
+                std::fabs(x - y) > 1e-5f * std::fabs(x)) {
+                std::cout << "expand_path mismatch at n = " << n << ", i = " << i
+                          << ", j = " << j << ": " << x << " vs " << y << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void floyd_warshall(float *r, const float *d, const size_t n, const size_t ld) {
+    for (size_t i = 0; i < n; ++i)
+        std::memcpy(r + ld * i, d + ld * i, n * sizeof(float));
+    for (size_t k = 0; k < n; ++k)
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j)
+                r[i * ld + j] = std::min(r[i * ld + j], r[i * ld + k] + r[k * ld + j]);
+}
@@ -11,11 +11,13 @@
 #include <omp.h>
 #include <algorithm>
 #include <cstring>
-#include <random>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 
+#include "pack.h"
+#include "rng.h"
+
 void create(float *d, size_t n);
 
 void trans(float *, const float *, const size_t);
@@ -57,31 +59,14 @@ int main() {
 }
 
 
+// [1, 20) 上保留两位小数、对角线为 0 的随机矩阵，按行并行生成，由 PPC_SEED 决定（见 rng.h）
 void create(float *d, const size_t n) {
-	std::random_device rd; // 用于生成种子
-	std::mt19937 gen(rd()); // 随机数引擎使用 Mersenne Twister 算法
-	std::uniform_real_distribution<> dis(1.0, 20.0);
-
-	for (size_t i = 0; i < n; ++i) {
-		for (size_t j = 0; j < n; ++j) {
-			if (i == j) {
-				d[i * n + j] = 0.0f; // 对角线元素设为 0
-			} else {
-				float random_value = dis(gen);
-				// 保留两位小数
-				float rounded_value = std::round(random_value * 100.0) / 100.0;
-				d[i * n + j] = rounded_value;
-			}
-		}
-	}
+	fill_random(d, n, n);
 }
 
+// 分块 + 8×8 寄存器转置（pack.h），逐元素按列读 d 在 n = 4000 时每次访问都跨一行
 void trans(float *t, const float *d, const size_t n) {
-	for (size_t i = 0; i < n; ++i) {
-		for (size_t j = 0; j < n; ++j) {
-			t[i * n + j] = d[j * n + i];
-		}
-	}
+	transpose(t, n, d, n, n);
 }
 
 void step(float *r, const float *d, const size_t n) {
@@ -0,0 +1,74 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/
+ * The shortcut problem
+ * 外存版本（见 outofcore.h）：输入、输出均为矩阵文件，内存中只保留几个面板
+ * 1. 不带参数：先用很小的内存预算（多个面板、面板数为奇数和偶数两种情况）与 step_simd_dispatch 逐位比较，
+ *    再对 n = 4000 的随机矩阵计时，输出 I/O 等待时间以确认 I/O 被计算掩盖
+ * 2. shortcut_ooc input.ppcm output.ppcm [内存预算 MB]：对文件中的矩阵做一次 step
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "matrix.h"
+#include "outofcore.h"
+
+void print_stats(const OocStats &s);
+
+int main(int argc, char **argv) {
+    numa_pin_threads();
+    if (argc > 2) {
+        OocOptions opt;
+        if (argc > 3)
+            opt.memory_budget = std::strtoull(argv[3], nullptr, 10) << 20;
+        OocStats s;
+        measure_time("step_out_of_core", [&]() {
+            s = step_out_of_core(argv[1], argv[2], opt);
+        });
+        print_stats(s);
+        return 0;
+    }
+
+    const std::string in = "ooc_in.ppcm", out = "ooc_out.ppcm";
+    for (size_t n: {1, 5, 97, 300, 1000}) {
+        for (size_t P: {3, 96, 192}) {
+            Matrix d(n, 0.f, true), r(n);
+            d.save(in);
+            step_simd_dispatch(r.get_pdata(), d.get_pdata(), n, d.get_ld());
+            OocOptions opt;
+            opt.panel_rows = P;
+            step_out_of_core(in, out, opt);
+            Matrix o = Matrix::open_file(out);
+            for (size_t i = 0; i < n; ++i) {
+                if (std::memcmp(o.get_pdata() + o.get_ld() * i, r.get_pdata() + r.get_ld() * i,
+                                n * sizeof(float)) != 0) {
+                    std::cout << "step_out_of_core mismatch at n = " << n << ", P = " << P << ", i = " << i << "\n";
+                    return 1;
+                }
+            }
+        }
+    }
+
+    constexpr int n = 4000;
+    {
+        Matrix d(n, 0.f, true);
+        d.save(in);
+    }
+    OocOptions opt;
+    opt.memory_budget = 256 << 20;
+    OocStats s;
+    measure_time("step_out_of_core", [&]() {
+        s = step_out_of_core(in, out, opt);
+    });
+    print_stats(s);
+    std::remove(in.c_str());
+    std::remove(out.c_str());
+}
+
+void print_stats(const OocStats &s) {
+    std::cout << "panel rows " << s.panel_rows << ", " << s.panels << " panels, read " << (s.bytes_read >> 20)
+              << " MB, written " << (s.bytes_written >> 20) << " MB\n"
+              << "transpose " << s.transpose_seconds << " s, compute " << s.compute_seconds
+              << " s, waiting for I/O " << s.io_wait_seconds << " s\n";
+}
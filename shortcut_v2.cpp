@@ -11,131 +11,44 @@
 *    （为什么要分成 p 块？正是由于 cpu cores 通常达不到 n 这个数量级，此时每个 core 会开一个 thread 去计算 w[m](0<=m<p)，
 *    与 step_trans_vec 不同在于每个 thread 会执行大约 n/p 次的 w[m] 计算，性能将大约可提升 p 倍）
 * 3. 值得一提的是，若将 p 设置成 n，则上述两个算法等效。
+* 4. n 不是 p 的倍数时，最后 n % p 个 k 不足一块，需要单独处理（并入 w[0]），否则这几项被漏掉
 */
 
 #include <algorithm>
-#include <chrono>
 
+#include "kernel_registry.h"
 #include "matrix.h"
-
-constexpr float inf = std::numeric_limits<float>::infinity();
-
-void step(float *r, const float *d, const size_t n);
-
-void step_trans(float *r, const float *d, const size_t n);
-
-void step_trans_vec(float *r, const float *d, const size_t n);
-
-void step_trans_ilp(float *r, const float *d, const size_t n);
-
-int main() {
-	constexpr int n = 2400;
-
-	Matrix d(n, 0.f, true);
-	// d.print();
-
-	Matrix r(n);
-	// r.print();
-
-
-	// auto start = std::chrono::high_resolution_clock::now();
-	// step(r.get_pdata(), d.get_pdata(), n);
-	// auto end = std::chrono::high_resolution_clock::now();
-	// std::chrono::duration<double> elapsed = end - start;
-	// std::cout << "Elapsed time: " << elapsed.count() << " s\n";
-	//
-	// start = std::chrono::high_resolution_clock::now();
-	// step_trans(r.get_pdata(), d.get_pdata(), n);
-	// end = std::chrono::high_resolution_clock::now();
-	// elapsed = end - start;
-	// std::cout << "Elapsed time: " << elapsed.count() << " s\n";
-
-	auto start = std::chrono::high_resolution_clock::now();
-	step_trans_vec(r.get_pdata(), d.get_pdata(), n);
-	auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> elapsed = end - start;
-	std::cout << "Elapsed time: " << elapsed.count() << " s\n";
-	// r.print();
-
-	start = std::chrono::high_resolution_clock::now();
-	step_trans_ilp(r.get_pdata(), d.get_pdata(), n);
-	end = std::chrono::high_resolution_clock::now();
-	elapsed = end - start;
-	std::cout << "Elapsed time: " << elapsed.count() << " s\n";
-	// r.print();
-}
-
-
-void step(float *r, const float *d, const size_t n) {
-	for (int i = 0; i < n; ++i) {
-		for (int j = 0; j < n; ++j) {
-			float v = std::numeric_limits<float>::infinity();
-			for (int k = 0; k < n; ++k) {
-				float x = d[n * i + k];
-				float y = d[n * k + j];
-				float z = x + y;
-				v = std::min(v, z);
-			}
-			r[n * i + j] = v;
-		}
-	}
-}
-
-
-void step_trans(float *r, const float *d, const size_t n) {
-	auto *t = new float[n * n * sizeof(float)];
-
-	for (size_t i = 0; i < n; ++i) {
-		for (size_t j = 0; j < n; ++j) {
-			t[i * n + j] = d[j * n + i];
-		}
-	}
-
-	for (int i = 0; i < n; ++i) {
-		for (int j = 0; j < n; ++j) {
-			float v = std::numeric_limits<float>::infinity();
-			for (int k = 0; k < n; ++k) {
-				float x = d[n * i + k];
-				float y = t[n * j + k];
-				float z = x + y;
-				v = std::min(v, z);
-			}
-			r[n * i + j] = v;
-		}
-	}
-	delete []t;
-}
-
-
-void step_trans_vec(float *r, const float *d, const size_t n) {
-	auto *t = new float[n * n * sizeof(float)];
-	for (size_t i = 0; i < n; ++i) {
-		for (size_t j = 0; j < n; ++j) {
-			t[i * n + j] = d[j * n + i];
-		}
+#include "pack.h"
+#include "prepared.h"
+
+void step_trans_vec(float *r, const float *d, const size_t n, const size_t ld) {
+	PackedOperand op("transpose", d, n, ld, n * ld * sizeof(float));
+	float *t = op.get<float>(0);
+	if (op.needs_build()) {
+		transpose(t, ld, d, n, ld);
+		op.built();
 	}
 	std::vector<float> w(n);
 	for (int i = 0; i < n; ++i) {
 		for (int j = 0; j < n; ++j) {
 			for (int k = 0; k < n; ++k) {
-				float x = d[n * i + k];
-				float y = t[n * j + k];
+				float x = d[ld * i + k];
+				float y = t[ld * j + k];
 				float z = x + y;
 				w[k] = z;
 			}
-			r[n * i + j] = *std::min_element(w.begin(), w.end());
+			r[ld * i + j] = *std::min_element(w.begin(), w.end());
 		}
 	}
-	delete []t;
 }
 
 
-void step_trans_ilp(float *r, const float *d, const size_t n) {
-	auto *t = new float[n * n * sizeof(float)];
-	for (size_t i = 0; i < n; ++i) {
-		for (size_t j = 0; j < n; ++j) {
-			t[i * n + j] = d[j * n + i];
-		}
+void step_trans_ilp(float *r, const float *d, const size_t n, const size_t ld) {
+	PackedOperand op("transpose", d, n, ld, n * ld * sizeof(float));
+	float *t = op.get<float>(0);
+	if (op.needs_build()) {
+		transpose(t, ld, d, n, ld);
+		op.built();
 	}
 
 	constexpr size_t p = 12;
@@ -146,14 +59,19 @@ void step_trans_ilp(float *r, const float *d, const size_t n) {
 				item = inf;
 			for (int k = 0; k < n / p; ++k) {
 				for (int m = 0; m < p; ++m) {
-					float x = d[n * i + k * p + m];
-					float y = t[n * j + k * p + m];
+					float x = d[ld * i + k * p + m];
+					float y = t[ld * j + k * p + m];
 					float z = x + y;
 					w[m] = std::min(w[m], z);
 				}
 			}
-			r[n * i + j] = *std::min_element(w, w + p);
+			// 不足一块的 n % p 个
+			for (int k = n / p * p; k < n; ++k)
+				w[0] = std::min(w[0], d[ld * i + k] + t[ld * j + k]);
+			r[ld * i + j] = *std::min_element(w, w + p);
 		}
 	}
-	delete []t;
 }
+
+PPC_REGISTER_KERNEL("step_trans_vec", step_trans_vec)
+PPC_REGISTER_KERNEL("step_trans_ilp", step_trans_ilp)
@@ -11,134 +11,43 @@
  */
 
 #include <algorithm>
-#include <chrono>
 
+#include "kernel_registry.h"
 #include "matrix.h"
-
-constexpr float inf = std::numeric_limits<float>::infinity();
-
-void step_trans(float *r, const float *d, const size_t n);
-
-void step_trans_omp(float *r, const float *d, const size_t n);
-
-void step_trans_ilp(float *r, const float *d, const size_t n);
-
-void step_trans_ilp_omp(float *r, const float *d, const size_t n);
-
-int main() {
-  constexpr int n = 2400;
-
-  Matrix d(n, 0.f, true);
-  // d.print();
-
-  Matrix r(n);
-  // r.print();
-
-  auto start = std::chrono::high_resolution_clock::now();
-  step_trans(r.get_pdata(), d.get_pdata(), n);
-  auto end = std::chrono::high_resolution_clock::now();
-  std::chrono::duration<double> elapsed = end - start;
-  std::cout << "Elapsed time: " << elapsed.count() << " s\n";
-  // r.print();
-
-  // start = std::chrono::high_resolution_clock::now();
-  // step_trans_omp(r.get_pdata(), d.get_pdata(), n);
-  // end = std::chrono::high_resolution_clock::now();
-  // elapsed = end - start;
-  // std::cout << "Elapsed time: " << elapsed.count() << " s\n";
-  // // r.print();
-
-  start = std::chrono::high_resolution_clock::now();
-  step_trans_ilp_omp(r.get_pdata(), d.get_pdata(), n);
-  end = std::chrono::high_resolution_clock::now();
-  elapsed = end - start;
-  std::cout << "Elapsed time: " << elapsed.count() << " s\n";
-  // r.print();
-}
-
-void step_trans(float *r, const float *d, const size_t n) {
-  auto *t = new float[n * n * sizeof(float)];
-  for (size_t i = 0; i < n; ++i) {
-    for (size_t j = 0; j < n; ++j) {
-      t[i * n + j] = d[j * n + i];
-    }
-  }
-  for (int i = 0; i < n; ++i) {
-    for (int j = 0; j < n; ++j) {
-      float v = inf;
-      for (int k = 0; k < n; ++k) {
-        float x = d[n * i + k];
-        float y = t[n * j + k];
-        float z = x + y;
-        v = std::min(v, z);
-      }
-      r[n * i + j] = v;
-    }
+#include "pack.h"
+#include "prepared.h"
+
+void step_trans_omp(float *r, const float *d, const size_t n, const size_t ld) {
+  PackedOperand op("transpose", d, n, ld, n * ld * sizeof(float));
+  float *t = op.get<float>(0);
+  if (op.needs_build()) {
+    transpose(t, ld, d, n, ld);
+    op.built();
   }
-  delete[] t;
-}
-
-void step_trans_omp(float *r, const float *d, const size_t n) {
-  auto *t = new float[n * n * sizeof(float)];
-#pragma omp parallel for
-  for (size_t i = 0; i < n; ++i) {
-    for (size_t j = 0; j < n; ++j) {
-      t[i * n + j] = d[j * n + i];
-    }
-  }
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
   for (int i = 0; i < n; ++i) {
     for (int j = 0; j < n; ++j) {
       float v = inf;
       for (int k = 0; k < n; ++k) {
-        float x = d[n * i + k];
-        float y = t[n * j + k];
+        float x = d[ld * i + k];
+        float y = t[ld * j + k];
         float z = x + y;
         v = std::min(v, z);
       }
-      r[n * i + j] = v;
+      r[ld * i + j] = v;
     }
   }
-  delete[] t;
 }
 
-void step_trans_ilp(float *r, const float *d, const size_t n) {
-  auto *t = new float[n * n * sizeof(float)];
-  for (size_t i = 0; i < n; ++i) {
-    for (size_t j = 0; j < n; ++j) {
-      t[i * n + j] = d[j * n + i];
-    }
-  }
-  constexpr size_t p = 12;
-  for (int i = 0; i < n; ++i) {
-    for (int j = 0; j < n; ++j) {
-      float w[p];
-      for (float &item : w)
-        item = inf;
-      for (int k = 0; k < n / p; ++k) {
-        for (int m = 0; m < p; ++m) {
-          float x = d[n * i + k * p + m];
-          float y = t[n * j + k * p + m];
-          float z = x + y;
-          w[m] = std::min(w[m], z);
-        }
-      }
-      r[n * i + j] = *std::min_element(w, w + p);
-    }
-  }
-  delete[] t;
-}
-
-void step_trans_ilp_omp(float *r, const float *d, const size_t n) {
-  auto *t = new float[n * n * sizeof(float)];
-#pragma omp parallel for
-  for (size_t i = 0; i < n; ++i) {
-    for (size_t j = 0; j < n; ++j) {
-      t[i * n + j] = d[j * n + i];
-    }
+void step_trans_ilp_omp(float *r, const float *d, const size_t n, const size_t ld) {
+  PackedOperand op("transpose", d, n, ld, n * ld * sizeof(float));
+  float *t = op.get<float>(0);
+  if (op.needs_build()) {
+    transpose(t, ld, d, n, ld);
+    op.built();
   }
   constexpr size_t p = 4;
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
   for (int i = 0; i < n; ++i) {
     for (int j = 0; j < n; ++j) {
       float w[p];
@@ -146,14 +55,19 @@ void step_trans_ilp_omp(float *r, const float *d, const size_t n) {
         item = inf;
       for (int k = 0; k < n / p; ++k) {
         for (int m = 0; m < p; ++m) {
-          float x = d[n * i + k * p + m];
-          float y = t[n * j + k * p + m];
+          float x = d[ld * i + k * p + m];
+          float y = t[ld * j + k * p + m];
           float z = x + y;
           w[m] = std::min(w[m], z);
         }
       }
-      r[n * i + j] = *std::min_element(w, w + p);
+      // 不足一块的 n % p 个
+      for (int k = n / p * p; k < n; ++k)
+        w[0] = std::min(w[0], d[ld * i + k] + t[ld * j + k]);
+      r[ld * i + j] = *std::min_element(w, w + p);
     }
   }
-  delete[] t;
 }
+
+PPC_REGISTER_KERNEL("step_trans_omp", step_trans_omp)
+PPC_REGISTER_KERNEL("step_trans_ilp_omp", step_trans_ilp_omp)
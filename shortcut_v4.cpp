@@ -0,0 +1,68 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/v4/
+ * The shortcut problem
+ * 在 v3-1 的基础上：寄存器分块（register blocking）
+ * 1. step_trans_simd_omp 中每次 vv = min(vv, x + y) 都需要从内存读入一个 x 和一个 y，瓶颈在 load 而不在计算
+ * 2. step_trans_simd_block_omp 每次内层循环计算 R×C 个输出 r[i][j]：读入 R 个 x 向量（vd 的 R 行）和 C 个 y 向量（vt 的 C 列），
+ *    每个 x 与 C 个 y 复用，共 R*C 个累加器常驻寄存器，每 R+C 次 load 完成 R*C 次 min-plus 更新
+ * 3. 默认 R = C = 3：9 个累加器 + 3 个 x + 3 个 y = 15 个 ymm 寄存器，不超过 AVX2 的 16 个
+ * 4. vd 的行数补齐到 R 的倍数、vt 的行数补齐到 C 的倍数，补齐部分填 inf，写回 r 时跳过越界的 i, j
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "kernel_registry.h"
+#include "matrix.h"
+#include "prepared.h"
+#include "simd.h"
+
+template <size_t R = 3, size_t C = 3>
+void step_trans_simd_block_omp(float *r, const float *d, size_t n, size_t ld);
+
+template <size_t R, size_t C>
+void step_trans_simd_block_omp(float *r, const float *d, const size_t n, const size_t ld) {
+    constexpr size_t vec_len = 8;
+    const size_t blocks = (n + vec_len - 1) / vec_len;
+    const size_t vs = packed_stride(blocks);
+    // 行数补齐到 R（列数补齐到 C）的倍数
+    const size_t na = (n + R - 1) / R;
+    const size_t nb = (n + C - 1) / C;
+
+    // vd[i] 为 d 的第 i 行，vt[j] 为 d 的第 j 列，越界部分均为 inf；R、C 不同时行数不同，布局也不同
+    const std::string key = "pack_simd/" + std::to_string(R) + "x" + std::to_string(C);
+    PackedOperand op(key.c_str(), d, n, ld, na * R * vs * sizeof(float8_t), nb * C * vs * sizeof(float8_t));
+    float8_t *vd = op.get<float8_t>(0);
+    float8_t *vt = op.get<float8_t>(1);
+    if (op.needs_build()) {
+        pack_simd(vd, na * R, vt, nb * C, d, n, ld, vs);
+        op.built();
+    }
+
+#pragma omp parallel for collapse(2)
+    for (size_t ic = 0; ic < na; ++ic) {
+        for (size_t jc = 0; jc < nb; ++jc) {
+            float8_t vv[R][C];
+            for (size_t a = 0; a < R; ++a)
+                for (size_t b = 0; b < C; ++b)
+                    vv[a][b] = f8inf;
+
+            const float8_t *x0 = &vd[(ic * R) * vs];
+            const float8_t *y0 = &vt[(jc * C) * vs];
+            minplus_block<R, C>(vv, x0, y0, vs, 0, blocks);
+
+            for (size_t a = 0; a < R; ++a) {
+                for (size_t b = 0; b < C; ++b) {
+                    size_t i = ic * R + a;
+                    size_t j = jc * C + b;
+                    if (i < n && j < n)
+                        r[ld * i + j] = hmin8(vv[a][b]);
+                }
+            }
+        }
+    }
+}
+
+PPC_REGISTER_KERNEL("step_trans_simd_block_omp<3,3>", step_trans_simd_block_omp<3, 3>)
+PPC_REGISTER_KERNEL("step_trans_simd_block_omp<4,2>", step_trans_simd_block_omp<4, 2>)
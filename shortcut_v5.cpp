@@ -0,0 +1,121 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/
+ * The shortcut problem
+ * 在 v4 的基础上：多级缓存分块（cache tiling）
+ * v4 对每个 3×3 输出块都要完整扫一遍 vd 的 3 行和 vt 的 3 行（n 较大时每行即几十 KB），
+ * 相邻输出块之间几乎没有缓存复用，n 超过几千后 L1/L2 被反复冲刷。
+ * step_trans_tiled_omp 将 i, j, k 三个维度按缓存大小切分：
+ * 1. L1：k 方向每次只处理 kc 个向量，3 行 x 的 kc 段（3*kc*32B）在扫过整个 j 分块期间常驻 L1
+ * 2. L2：j 方向每个分块 nc 行，vt 的 nc×kc 子块在扫过整个 i 分块期间常驻 L2
+ * 3. L3：i 方向每个分块 mc 行；输出块按 j 优先编号，相邻线程处理同一个 j 分块，共享 L3 中 vt 的同一段
+ * 每个 k 分块结束后把 9 个累加器的水平最小值并入输出块的部分最小值 part，因此任意 n 均可处理，
+ * 不要求 n 是分块大小的整数倍。part 每个线程一份，在并行区域之前用 scratch_array 一次申请好，循环中不再分配。
+ */
+
+#include <algorithm>
+#include <omp.h>
+
+#include "kernel_registry.h"
+#include "matrix.h"
+#include "prepared.h"
+#include "simd.h"
+#include "workspace.h"
+
+// 各级分块大小（kc 以向量为单位，mc/nc 以行为单位，需为 3 的倍数）
+struct TileConfig {
+    size_t kc = 128;    // L1: 6 * 128 * 32B = 24KB
+    size_t mc = 96;     // L3: 96 * 128 * 32B = 384KB / 线程
+    size_t nc = 96;     // L2: 96 * 128 * 32B = 384KB
+};
+
+void step_trans_tiled_omp(float *r, const float *d, size_t n, size_t ld);
+
+void step_trans_tiled_omp(float *r, const float *d, size_t n, size_t ld, const TileConfig &cfg);
+
+void step_trans_tiled_omp(float *r, const float *d, const size_t n, const size_t ld) {
+    step_trans_tiled_omp(r, d, n, ld, TileConfig{});
+}
+
+void step_trans_tiled_omp(float *r, const float *d, const size_t n, const size_t ld, const TileConfig &cfg) {
+    constexpr size_t vec_len = 8;
+    constexpr size_t R = 3, C = 3;
+    const size_t blocks = (n + vec_len - 1) / vec_len;
+    const size_t vs = packed_stride(blocks);
+    const size_t nn = (n + R - 1) / R;  // 3 行一组的组数
+
+    // 与 v4 的 step_trans_simd_block_omp<3, 3> 布局相同，共享缓存
+    PackedOperand op("pack_simd/3x3", d, n, ld, nn * R * vs * sizeof(float8_t), nn * C * vs * sizeof(float8_t));
+    float8_t *vd = op.get<float8_t>(0);
+    float8_t *vt = op.get<float8_t>(1);
+    if (op.needs_build()) {
+        pack_simd(vd, nn * R, vt, nn * C, d, n, ld, vs);
+        op.built();
+    }
+
+    // 分块大小换算为 3 行一组的组数，至少为 1
+    const size_t kc = std::max<size_t>(cfg.kc, 1);
+    const size_t mc = std::max<size_t>(cfg.mc / R, 1);
+    const size_t nc = std::max<size_t>(cfg.nc / C, 1);
+    const size_t mt = (nn + mc - 1) / mc;
+    const size_t nt = (nn + nc - 1) / nc;
+
+    // 每个线程一块 part（mc×nc 个输出），按 cache line 对齐，避免相邻线程的 part 共享 cache line
+    const size_t part_stride = (mc * R * nc * C + 15) / 16 * 16;
+    huge_ptr<float> parts = scratch_array<float>(part_stride * omp_get_max_threads());
+
+#pragma omp parallel
+    {
+        float *part = parts.get() + part_stride * omp_get_thread_num();
+#pragma omp for schedule(static)
+        for (size_t t = 0; t < mt * nt; ++t) {
+            // j 分块在外：相邻的 t 属于同一个 j 分块
+            const size_t jt = t / mt, it = t % mt;
+            const size_t ic0 = it * mc, ic1 = std::min(ic0 + mc, nn);
+            const size_t jc0 = jt * nc, jc1 = std::min(jc0 + nc, nn);
+
+            // 当前输出块的部分最小值
+            const size_t ldp = (jc1 - jc0) * C;
+            std::fill(part, part + (ic1 - ic0) * R * ldp, inf);
+
+            for (size_t k0 = 0; k0 < blocks; k0 += kc) {
+                const size_t k1 = std::min(k0 + kc, blocks);
+                for (size_t ic = ic0; ic < ic1; ++ic) {
+                    const float8_t *x0 = &vd[(ic * R) * vs];
+                    for (size_t jc = jc0; jc < jc1; ++jc) {
+                        const float8_t *y0 = &vt[(jc * C) * vs];
+                        float8_t vv[R][C];
+                        for (size_t a = 0; a < R; ++a)
+                            for (size_t b = 0; b < C; ++b)
+                                vv[a][b] = f8inf;
+
+                        minplus_block<R, C>(vv, x0, y0, vs, k0, k1);
+
+                        for (size_t a = 0; a < R; ++a) {
+                            for (size_t b = 0; b < C; ++b) {
+                                float &p = part[((ic - ic0) * R + a) * ldp + (jc - jc0) * C + b];
+                                p = std::min(p, hmin8(vv[a][b]));
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (size_t ii = 0; ii < (ic1 - ic0) * R; ++ii) {
+                const size_t i = ic0 * R + ii;
+                if (i >= n)
+                    break;
+                for (size_t jj = 0; jj < ldp; ++jj) {
+                    const size_t j = jc0 * C + jj;
+                    if (j >= n)
+                        break;
+                    r[ld * i + j] = part[ii * ldp + jj];
+                }
+            }
+        }
+    }
+}
+
+PPC_REGISTER_KERNEL("step_trans_tiled_omp", step_trans_tiled_omp)
+PPC_REGISTER_KERNEL("step_trans_tiled_omp(kc=256,mc=nc=48)", [](float *r, const float *d, size_t n, size_t ld) {
+    step_trans_tiled_omp(r, d, n, ld, TileConfig{256, 48, 48});
+})
@@ -0,0 +1,130 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/v7/
+ * The shortcut problem
+ * 在 v4 的基础上：按 Z-order（Morton）/ Hilbert 曲线遍历输出块
+ * 1. v3 / v3-1 / v4 中 OpenMP 按 i、j 的行优先顺序分配任务，每个线程处理一行 i 时要扫过全部 vt，
+ *    相邻两行之间几乎没有 L2/L3 复用
+ * 2. step_trans_zorder_omp 按空间填充曲线的顺序处理所有 3×3 输出块 (ic, jc)：
+ *    曲线上相邻的块在 ic、jc 两个方向上都相近，连续处理的块共享大部分输入行
+ *    循环变量 t 就是曲线上的序号，在循环体内直接解码出 (ic, jc)，不建块表、不排序（nn^2 个块的表在 n = 16000 时有几百 MB）；
+ *    曲线铺在边长为 2 的幂（side >= nn）的正方形上，落在 nn×nn 之外的序号直接跳过
+ * 3. 按曲线上对齐的 64 个序号（8×8 个块组成的正方形）为一份动态分给各线程：nn 不是 2 的幂时，
+ *    大段序号落在 nn×nn 之外，静态等分会让各线程的块数相差很多
+ * 4. k 方向切成 kc 个向量一段，每段内所有块的输入（几十行 × kc）可常驻缓存；每段结束后把部分最小值并入 r
+ * 5. order 可选 RowMajor（对照）、ZOrder（位交错）、Hilbert（相邻块始终共享一行或一列）
+ * 三种顺序的 L3 缺失可用 ./bench --kernels='step_trans_zorder_omp*' --counters=auto 对比（需要 PMU，见 perf_counters.h）
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+#include "kernel_registry.h"
+#include "matrix.h"
+#include "prepared.h"
+#include "simd.h"
+
+enum class TileOrder { RowMajor, ZOrder, Hilbert };
+
+void step_trans_zorder_omp(float *r, const float *d, size_t n, size_t ld);
+
+void step_trans_zorder_omp(float *r, const float *d, size_t n, size_t ld, TileOrder order, size_t kc = 256);
+
+// morton 序号的解码：偶数位组成 x，奇数位组成 y
+static inline void morton_decode(uint64_t key, uint32_t &x, uint32_t &y) {
+    x = y = 0;
+    for (int b = 0; b < 32; ++b) {
+        x |= (uint32_t) ((key >> (2 * b)) & 1) << b;
+        y |= (uint32_t) ((key >> (2 * b + 1)) & 1) << b;
+    }
+}
+
+// 边长为 side（2 的幂）的 Hilbert 曲线上第 key 个点的坐标 (x, y)
+static inline void hilbert_decode(uint64_t key, uint32_t side, uint32_t &x, uint32_t &y) {
+    x = y = 0;
+    for (uint32_t s = 1; s < side; s *= 2) {
+        uint32_t rx = 1 & (key / 2);
+        uint32_t ry = 1 & (key ^ rx);
+        // 旋转象限
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+        x += s * rx;
+        y += s * ry;
+        key /= 4;
+    }
+}
+
+void step_trans_zorder_omp(float *r, const float *d, const size_t n, const size_t ld) {
+    step_trans_zorder_omp(r, d, n, ld, TileOrder::ZOrder);
+}
+
+void step_trans_zorder_omp(float *r, const float *d, const size_t n, const size_t ld, TileOrder order, size_t kc) {
+    constexpr size_t vec_len = 8;
+    constexpr size_t R = 3, C = 3;
+    const size_t blocks = (n + vec_len - 1) / vec_len;
+    const size_t vs = packed_stride(blocks);
+    const size_t nn = (n + R - 1) / R;
+    kc = std::max<size_t>(kc, 1);
+
+    // 与 v4 的 step_trans_simd_block_omp<3, 3> 布局相同，共享缓存
+    PackedOperand op("pack_simd/3x3", d, n, ld, nn * R * vs * sizeof(float8_t), nn * C * vs * sizeof(float8_t));
+    float8_t *vd = op.get<float8_t>(0);
+    float8_t *vt = op.get<float8_t>(1);
+    if (op.needs_build()) {
+        pack_simd(vd, nn * R, vt, nn * C, d, n, ld, vs);
+        op.built();
+    }
+
+    uint32_t side = 1;
+    while (side < nn)
+        side *= 2;
+    const size_t count = order == TileOrder::RowMajor ? nn * nn : (size_t) side * side;
+
+#pragma omp parallel for
+    for (size_t i = 0; i < n; ++i)
+        std::fill(r + ld * i, r + ld * i + n, inf);
+
+    for (size_t k0 = 0; k0 < blocks; k0 += kc) {
+        const size_t k1 = std::min(k0 + kc, blocks);
+        // 每份是曲线上连续的 64 个序号，即一个 8×8 块的正方形
+#pragma omp parallel for schedule(dynamic, 64)
+        for (size_t t = 0; t < count; ++t) {
+            uint32_t ic = t / nn, jc = t % nn;
+            if (order == TileOrder::ZOrder)
+                morton_decode(t, ic, jc);
+            else if (order == TileOrder::Hilbert)
+                hilbert_decode(t, side, ic, jc);
+            if (ic >= nn || jc >= nn)
+                continue;
+            float8_t vv[R][C];
+            for (size_t a = 0; a < R; ++a)
+                for (size_t b = 0; b < C; ++b)
+                    vv[a][b] = f8inf;
+
+            minplus_block<R, C>(vv, &vd[(ic * R) * vs], &vt[(jc * C) * vs], vs, k0, k1);
+
+            for (size_t a = 0; a < R; ++a) {
+                for (size_t b = 0; b < C; ++b) {
+                    size_t i = ic * R + a;
+                    size_t j = jc * C + b;
+                    if (i < n && j < n)
+                        r[ld * i + j] = std::min(r[ld * i + j], hmin8(vv[a][b]));
+                }
+            }
+        }
+    }
+}
+
+PPC_REGISTER_KERNEL("step_trans_zorder_omp(RowMajor)", [](float *r, const float *d, size_t n, size_t ld) {
+    step_trans_zorder_omp(r, d, n, ld, TileOrder::RowMajor);
+})
+PPC_REGISTER_KERNEL("step_trans_zorder_omp(ZOrder)", [](float *r, const float *d, size_t n, size_t ld) {
+    step_trans_zorder_omp(r, d, n, ld, TileOrder::ZOrder);
+})
+PPC_REGISTER_KERNEL("step_trans_zorder_omp(Hilbert)", [](float *r, const float *d, size_t n, size_t ld) {
+    step_trans_zorder_omp(r, d, n, ld, TileOrder::Hilbert);
+})
@@ -0,0 +1,118 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/v6/
+ * The shortcut problem
+ * 在 v4 的基础上：软件预取（software prefetching）
+ * 1. step_trans_simd_omp / v4 的内层循环是对 vd、vt 行的线性扫描，硬件预取器能跟上；
+ *    但每开始一个新的 (i, j) 输出块时要跳到另外几行，硬件预取器需要重新“热身”，perf 中表现为行边界处的长时间停顿
+ * 2. 这里把 3 行交错存放（第 k 个向量的 3 行相邻），一个输出块只读 x、y 两条连续的数据流
+ * 3. 内层循环对 k + pf 处的数据发出 __builtin_prefetch；当 k + pf 越过当前行尾时，
+ *    改为预取“下一个输出块”将要读的数据，从而在行边界之前就开始加载
+ * 4. 预取距离 pf（单位：k 方向的步数）可在运行时调整：参数传入，或通过环境变量 PPC_PREFETCH_DIST 设置
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "kernel_registry.h"
+#include "matrix.h"
+#include "prepared.h"
+#include "simd.h"
+
+constexpr size_t default_prefetch_dist = 20;
+
+void step_trans_simd_prefetch_omp(float *r, const float *d, size_t n, size_t ld);
+
+void step_trans_simd_prefetch_omp(float *r, const float *d, size_t n, size_t ld, size_t pf);
+
+// 预取距离：环境变量 PPC_PREFETCH_DIST，未设置时使用默认值
+static size_t prefetch_dist() {
+    const char *env = std::getenv("PPC_PREFETCH_DIST");
+    return env ? std::strtoul(env, nullptr, 10) : default_prefetch_dist;
+}
+
+void step_trans_simd_prefetch_omp(float *r, const float *d, const size_t n, const size_t ld) {
+    step_trans_simd_prefetch_omp(r, d, n, ld, prefetch_dist());
+}
+
+/* vd / vt 的交错布局：第 ic 组（3 行）的第 k 个向量位于 vd[(ic * blocks + k) * R + a]，a 为组内行号
+ * 这样每组 3 行的数据是一段连续内存，且第 ic + 1 组紧跟在第 ic 组之后
+ */
+void step_trans_simd_prefetch_omp(float *r, const float *d, const size_t n, const size_t ld, const size_t pf) {
+    constexpr size_t vec_len = 8;
+    constexpr size_t R = 3, C = 3;
+    const size_t blocks = (n + vec_len - 1) / vec_len;
+    const size_t na = (n + R - 1) / R;
+    const size_t nb = (n + C - 1) / C;
+
+    PackedOperand op("interleaved/3x3", d, n, ld, na * R * blocks * sizeof(float8_t),
+                     nb * C * blocks * sizeof(float8_t));
+    float8_t *vd = op.get<float8_t>(0);
+    float8_t *vt = op.get<float8_t>(1);
+
+    if (op.needs_build()) {
+        pack_rows(GroupedLayout{reinterpret_cast<float *>(vd), blocks, R}, na * R, blocks * vec_len, d, n, n, ld);
+        pack_cols(GroupedLayout{reinterpret_cast<float *>(vt), blocks, C}, nb * C, blocks * vec_len, d, n, n, ld);
+        op.built();
+    }
+
+    // 当前块读到 k 时预取 k + pf；超出本块的部分改为预取下一块的开头
+    // pf > blocks 时 k + pf - blocks 可能越过下一块的末尾，截到它的最后一步，指针不超出 vd、vt
+    const size_t k_split = blocks > pf ? blocks - pf : 0;
+
+#pragma omp parallel for schedule(static)
+    for (size_t p = 0; p < na * nb; ++p) {
+        const size_t ic = p / nb, jc = p % nb;
+        const size_t q = p + 1 < na * nb ? p + 1 : p;
+        const float8_t *x = &vd[ic * blocks * R];
+        const float8_t *y = &vt[jc * blocks * C];
+        const float8_t *xn = &vd[(q / nb) * blocks * R];
+        const float8_t *yn = &vt[(q % nb) * blocks * C];
+
+        float8_t vv[R][C];
+        for (size_t a = 0; a < R; ++a)
+            for (size_t b = 0; b < C; ++b)
+                vv[a][b] = f8inf;
+
+        for (size_t k = 0; k < blocks; ++k) {
+            // 每步读 R（C）个向量即 96 字节，可能跨两条 cache line，两条都预取
+            const size_t kn = k < k_split ? 0 : std::min(k + pf - blocks, blocks - 1);
+            const float8_t *px = k < k_split ? x + (k + pf) * R : xn + kn * R;
+            const float8_t *py = k < k_split ? y + (k + pf) * C : yn + kn * C;
+            __builtin_prefetch(px);
+            __builtin_prefetch(px + 2);
+            __builtin_prefetch(py);
+            __builtin_prefetch(py + 2);
+
+            float8_t xx[R], yy[C];
+            for (size_t a = 0; a < R; ++a)
+                xx[a] = x[k * R + a];
+            for (size_t b = 0; b < C; ++b)
+                yy[b] = y[k * C + b];
+            for (size_t a = 0; a < R; ++a)
+                for (size_t b = 0; b < C; ++b)
+                    vv[a][b] = min8(vv[a][b], xx[a] + yy[b]);
+        }
+
+        for (size_t a = 0; a < R; ++a) {
+            for (size_t b = 0; b < C; ++b) {
+                size_t i = ic * R + a;
+                size_t j = jc * C + b;
+                if (i < n && j < n)
+                    r[ld * i + j] = hmin8(vv[a][b]);
+            }
+        }
+    }
+}
+
+// 默认预取距离（PPC_PREFETCH_DIST）以及几个固定的预取距离，pf=0 即不预取
+PPC_REGISTER_KERNEL("step_trans_simd_prefetch_omp", step_trans_simd_prefetch_omp)
+PPC_REGISTER_KERNEL("step_trans_simd_prefetch_omp(pf=0)", [](float *r, const float *d, size_t n, size_t ld) {
+    step_trans_simd_prefetch_omp(r, d, n, ld, 0);
+})
+PPC_REGISTER_KERNEL("step_trans_simd_prefetch_omp(pf=8)", [](float *r, const float *d, size_t n, size_t ld) {
+    step_trans_simd_prefetch_omp(r, d, n, ld, 8);
+})
+PPC_REGISTER_KERNEL("step_trans_simd_prefetch_omp(pf=40)", [](float *r, const float *d, size_t n, size_t ld) {
+    step_trans_simd_prefetch_omp(r, d, n, ld, 40);
+})
@@ -0,0 +1,39 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/
+ * The shortcut problem
+ * 在 v5 的基础上：运行时指令集分派（见 dispatch.h）
+ * 同一个二进制中同时包含 4 / 8 / 16 lane 三个版本的内核，启动时按 cpuid 选择，
+ * 也可以用环境变量 PPC_ISA=sse|avx2|avx512 指定，例如：
+ *     PPC_ISA=avx2 ./bench --kernels=step_simd_dispatch
+ * 编译时不需要（也不应该）加 -march=native
+ * 各级别单独注册，可以在同一次运行中对比；n = 2048 附近不补齐（ld = n）与默认行距（Matrix::padded_ld）的对比用
+ *     ./bench --kernels=step_simd_dispatch --sizes=2047,2048,2049 --ld=n
+ * step_argmin_*（同时求出中间点 k，apsp.h 使用）也在这里注册，下标写入临时数组，距离与其他内核一样逐位检查：
+ *     ./bench --verify --kernels='step_argmin*'
+ * 与同一 ISA 的 step_simd_* 的耗时比较与中间点的检查见 ./bench --argmin
+ */
+
+#include "kernel_registry.h"
+#include "dispatch.h"
+
+PPC_REGISTER_KERNEL("step_simd_dispatch", step_simd_dispatch)
+PPC_REGISTER_KERNEL("step_simd_sse", step_simd_sse)
+PPC_REGISTER_KERNEL("step_simd_avx2", step_simd_avx2, [] { return detect_isa() >= SimdIsa::AVX2; })
+PPC_REGISTER_KERNEL("step_simd_avx512", step_simd_avx512, [] { return detect_isa() >= SimdIsa::AVX512; })
+
+PPC_REGISTER_KERNEL("step_argmin_dispatch", [](float *r, const float *d, size_t n, size_t ld) {
+    huge_ptr<int> p = scratch_array<int>(n * ld);
+    step_argmin_dispatch(r, p.get(), d, n, ld);
+})
+PPC_REGISTER_KERNEL("step_argmin_sse", [](float *r, const float *d, size_t n, size_t ld) {
+    huge_ptr<int> p = scratch_array<int>(n * ld);
+    step_argmin_sse(r, p.get(), d, n, ld);
+})
+PPC_REGISTER_KERNEL("step_argmin_avx2", [](float *r, const float *d, size_t n, size_t ld) {
+    huge_ptr<int> p = scratch_array<int>(n * ld);
+    step_argmin_avx2(r, p.get(), d, n, ld);
+}, [] { return detect_isa() >= SimdIsa::AVX2; })
+PPC_REGISTER_KERNEL("step_argmin_avx512", [](float *r, const float *d, size_t n, size_t ld) {
+    huge_ptr<int> p = scratch_array<int>(n * ld);
+    step_argmin_avx512(r, p.get(), d, n, ld);
+}, [] { return detect_isa() >= SimdIsa::AVX512; })
@@ -0,0 +1,14 @@
+/**
+ * https://ppc.cs.aalto.fi/ch2/
+ * The shortcut problem
+ * 在 v8 的基础上：AVX-512 16 lane 内核，用掩码寄存器处理尾部（见 dispatch.h 中的 step_avx512_masked）
+ * 1. step_trans_simd_omp 需要把 d 补齐成 vd / vt 两份向量化副本，尾部填 inf 对齐到 8 个 lane
+ * 2. step_avx512_masked 沿 j 方向向量化，直接读 d 的行，不需要转置；最后不足 16 列用 masked load / store，
+ *    因此没有任何补齐副本，每条指令处理 16 个 lane
+ * 3. 对任意 n（包括奇数）结果与 step_trans 逐位一致，可用 ./bench --kernels=step_avx512_masked --check 校验
+ */
+
+#include "kernel_registry.h"
+#include "dispatch.h"
+
+PPC_REGISTER_KERNEL("step_avx512_masked", step_avx512_masked, [] { return detect_isa() == SimdIsa::AVX512; })
@@ -0,0 +1,133 @@
+/**
+ * SIMD 相关的公共定义：float8_t 向量类型、inf 常量、水平归约以及计时函数
+ * 供 shortcut_v3-1.cpp 之后的各个版本共用
+ * measure_time 在硬件计数器可用时（perf_counters.h）额外输出 cycles、IPC、各级缺失等，多线程时按线程分别输出
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "pack.h"
+#include "perf_counters.h"
+
+typedef float float8_t __attribute__ ((vector_size(8 * sizeof(float))));
+
+/* 任意长度（L 个 float）的向量类型：floatv_t<4> 对应 SSE，floatv_t<8> 即 float8_t，floatv_t<16> 对应 AVX-512
+ * 显式指定 aligned：否则在未开启 AVX 的编译单元中 GCC 只给 16 字节对齐，
+ * 而 target("avx2") / target("avx512f") 的函数会按 32 / 64 字节对齐访问（memory_alignment.cpp）。
+ * 由于 std::vector<floatv_t<L>> 会丢掉 aligned 属性，这类数组需用 aligned_alloc 分配
+ */
+template <size_t L>
+struct floatv {
+    typedef float type __attribute__ ((vector_size(L * sizeof(float)), aligned(L * sizeof(float))));
+};
+
+template <size_t L>
+using floatv_t = typename floatv<L>::type;
+
+// 与 floatv_t<L> 等长的 int 向量，floatv_t 之间比较的结果即为此类型
+template <size_t L>
+struct intv {
+    typedef int type __attribute__ ((vector_size(L * sizeof(int)), aligned(L * sizeof(int))));
+};
+
+template <size_t L>
+using intv_t = typename intv<L>::type;
+
+constexpr float inf = std::numeric_limits<float>::infinity();
+
+constexpr float8_t f8inf{
+    inf, inf, inf, inf, inf, inf, inf, inf
+};
+
+static inline float hmin8(float8_t vv) {
+    float v = inf;
+    for (int i = 0; i < 8; ++i) {
+        v = std::min(vv[i], v);
+    }
+    return v;
+}
+
+static inline float8_t min8(float8_t x, float8_t y) {
+    return x < y ? x : y;
+}
+
+/* 打包后每行占多少个 L lane 的向量：至少 blocks 个，补齐到奇数条 cache line
+ * 与 Matrix::padded_ld 的理由相同：blocks 为 2 的较大次幂时（n = 2048、4096 等）行距是 4KB 的倍数，
+ * 内核同时读的 R + C 行会落在 L1 的同一组里
+ */
+template <size_t L = 8>
+inline size_t packed_stride(size_t blocks) {
+    constexpr size_t per_line = 64 / (L * sizeof(float));
+    size_t lines = (blocks + per_line - 1) / per_line;
+    if (lines % 2 == 0 && lines > 0)
+        ++lines;
+    return lines * per_line;
+}
+
+/* 将 d（n×n，行距 ld）补齐并转换为向量（pack.h 中的分块转置）：
+ * vd 共 rows_d 行，vd[i * vs + b] 为 d 第 i 行的第 b 个向量
+ * vt 共 rows_t 行，vt[j * vs + b] 为 d 第 j 列的第 b 个向量
+ * vs 为打包后的行距（向量个数，>= blocks，一般取 packed_stride(blocks)）
+ * 越界（i >= n 或 j >= n）的部分均为 inf，每行 blocks 之后的部分不写
+ */
+static inline void pack_simd(float8_t *vd, size_t rows_d, float8_t *vt, size_t rows_t,
+                             const float *d, size_t n, size_t ld, size_t vs) {
+    constexpr size_t vec_len = 8;
+    const size_t blocks = (n + vec_len - 1) / vec_len;
+    pack_rows(RowLayout{reinterpret_cast<float *>(vd), vs * vec_len}, rows_d, blocks * vec_len, d, n, n, ld);
+    pack_cols(RowLayout{reinterpret_cast<float *>(vt), vs * vec_len}, rows_t, blocks * vec_len, d, n, n, ld);
+}
+
+/* R×C 寄存器分块的 min-plus 内核：
+ * x0 指向 R 行、y0 指向 C 行（行间距均为 vs 个向量），在 [k0, k1) 范围内更新 R*C 个累加器 vv
+ */
+template <size_t R, size_t C>
+static inline void minplus_block(float8_t (&vv)[R][C], const float8_t *x0, const float8_t *y0,
+                                 size_t vs, size_t k0, size_t k1) {
+    for (size_t k = k0; k < k1; ++k) {
+        float8_t x[R], y[C];
+        for (size_t a = 0; a < R; ++a)
+            x[a] = x0[a * vs + k];
+        for (size_t b = 0; b < C; ++b)
+            y[b] = y0[b * vs + k];
+        for (size_t a = 0; a < R; ++a)
+            for (size_t b = 0; b < C; ++b)
+                vv[a][b] = min8(vv[a][b], x[a] + y[b]);
+    }
+}
+
+// 计时函数；计数器不可用时只输出墙钟时间
+inline void measure_time(const std::string &func_name, const std::function<void()> &func) {
+    PerfCounters pc;
+    pc.start();
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto end = std::chrono::high_resolution_clock::now();
+    pc.stop();
+    std::chrono::duration<double> elapsed = end - start;
+    std::cout << func_name << " elapsed time: " << elapsed.count() << " s\n";
+    if (!pc.available())
+        return;
+    std::cout << "  ";
+    print_perf_counts(std::cout, pc.total());
+    std::cout << "\n";
+    if (pc.threads() > 1) {
+        for (size_t t = 0; t < pc.threads(); ++t) {
+            std::cout << "  thread " << t << ": ";
+            print_perf_counts(std::cout, pc.per_thread()[t]);
+            std::cout << "\n";
+        }
+    }
+}
+
+#endif //SIMD_H
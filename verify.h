@@ -0,0 +1,121 @@
+/**
+ * 各内核的正确性校验（./bench --verify），供 bench.cpp 使用
+ * 所有内核都应与 v0 的 step 逐位一致：min-plus 中每一项 x + y 的舍入与计算顺序无关，取 min 也与顺序无关，
+ * 只要输入中没有 NaN 和 -0，任何分块、向量化、并行方式的结果都必须与参考实现完全相同，不允许“误差范围内相等”。
+ * 输入分为几类，分别覆盖不同的错误：
+ * - random：一般的随机矩阵（rng.h），n 为 8 / 16 的倍数附近的常见规模
+ * - odd：奇数规模，覆盖向量化 / 分块 / ILP 的尾部（n 不是 lane 数、块大小的倍数）
+ * - tiny：n = 1..17，比一个向量、一个寄存器块还小
+ * - inf：约 3/4 的边为 inf（不可达），补齐用的 inf 与真实的 inf 混在一起
+ * - negative：[-20, 20) 上的权重，min 不再总是由较小的正数取得，0 只会是 +0
+ * 每种输入分别用默认行距和不补齐的行距（ld = n）各跑一次。
+ * 此外检查内核只写每行的前 n 列：r 的补齐部分事先填入一个特殊的 NaN，运行后必须保持不变。
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "rng.h"
+
+enum class InputClass { Random, Odd, Tiny, InfHeavy, Negative };
+
+inline const char *input_class_name(const InputClass c) {
+    switch (c) {
+        case InputClass::Random: return "random";
+        case InputClass::Odd: return "odd";
+        case InputClass::Tiny: return "tiny";
+        case InputClass::InfHeavy: return "inf";
+        default: return "negative";
+    }
+}
+
+struct VerifyCase {
+    InputClass cls;
+    size_t n;
+    bool padded; // true：默认行距（Matrix::padded_ld），false：ld = n
+};
+
+inline std::vector<VerifyCase> verify_cases() {
+    std::vector<std::pair<InputClass, std::vector<size_t>>> sizes = {
+        {InputClass::Random, {64, 128, 200, 256}},
+        {InputClass::Odd, {31, 33, 63, 65, 97, 101, 127, 129, 255, 257}},
+        {InputClass::Tiny, {}},
+        {InputClass::InfHeavy, {5, 17, 64, 97}},
+        {InputClass::Negative, {5, 17, 64, 97}},
+    };
+    for (size_t n = 1; n <= 17; ++n)
+        sizes[2].second.push_back(n);
+    std::vector<VerifyCase> cases;
+    for (const auto &s: sizes)
+        for (const size_t n: s.second)
+            for (const bool padded: {true, false})
+                cases.push_back(VerifyCase{s.first, n, padded});
+    return cases;
+}
+
+// 按输入类别填充 d（n×n，行距 ld）；与 fill_random 一样只由 seed 决定
+inline void fill_verify_input(float *d, const size_t n, const size_t ld, const InputClass cls, const uint64_t seed) {
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    fill_random(d, n, ld, seed);
+    if (cls != InputClass::InfHeavy && cls != InputClass::Negative)
+        return;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = splitmix64(~seed, i);
+        const uint32_t k0 = (uint32_t) key, k1 = (uint32_t) (key >> 32);
+        for (size_t j = 0; j < n; ++j) {
+            if (i == j)
+                continue;
+            const uint32_t t = mix32(mix32((uint32_t) j + k0) ^ k1);
+            if (cls == InputClass::InfHeavy) {
+                if (t % 4 != 0)
+                    d[ld * i + j] = inf;
+            } else {
+                // [-2000, 2000) 分，(float) 0 / 100 为 +0
+                const int cents = (int) ((4000ull * t) >> 32) - 2000;
+                d[ld * i + j] = (float) cents / 100.f;
+            }
+        }
+    }
+}
+
+// 写入 r 的补齐部分的哨兵：一个带特定负载的 quiet NaN，任何计算都不会产生它
+inline float padding_sentinel() {
+    const uint32_t bits = 0x7fc0deadu;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+struct Mismatch {
+    size_t i, j;
+    float got, want;
+    bool padding; // true：写到了补齐部分（j >= n）
+};
+
+/* 逐位比较 r 与参考结果 ref（均为 n×n、行距 ld），并检查 r 的补齐部分仍为哨兵
+ * 返回不一致的元素总数，前 max_report 个的坐标写入 out
+ */
+inline size_t compare_bitwise(const float *r, const float *ref, const size_t n, const size_t ld,
+                              std::vector<Mismatch> &out, const size_t max_report = 4) {
+    const float sentinel = padding_sentinel();
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < ld; ++j) {
+            const float want = j < n ? ref[ld * i + j] : sentinel;
+            if (std::memcmp(&r[ld * i + j], &want, sizeof(float)) == 0)
+                continue;
+            if (count++ < max_report)
+                out.push_back(Mismatch{i, j, r[ld * i + j], want, j >= n});
+        }
+    }
+    return count;
+}
+
+#endif //VERIFY_H
@@ -0,0 +1,178 @@
+/**
+ * 可复用的工作区（arena），内核的临时数组（转置副本 t、补齐打包的 vd / vt 等）从这里借用
+ * 原来每次调用都 huge_array 一块新的内存、用完即释放；同样大小的输入反复调用时（服务中每分钟上千次），
+ * 每次都要重新 mmap、缺页、由内核清零几十到几百 MB，纯属浪费。Workspace 把这些内存留下来给下一次调用：
+ * 1. take(bytes) 从当前块中按 64 字节对齐顺序切出一段（bump allocation），不够时再 huge_alloc 一个新块，
+ *    新块至少与已有的总容量一样大，因此块数按对数增长
+ * 2. 一次调用结束、下一次开始时（WorkspaceScope 构造时 reset）借出的内存全部作废；
+ *    上一次用到了多个块时合并成一个能容纳峰值用量的块，之后同样大小的调用不再有任何分配
+ * 3. 内存只在 Workspace 析构时释放；大块同样经 huge_alloc 按大页分配（见 hugepage.h）
+ *
+ * 内核不直接接收 Workspace：调用者用 WorkspaceScope 把它设为当前线程的工作区，内核中的 scratch_array<T>(count)
+ * 在有当前工作区时从中借用（离开作用域时不释放），否则与 huge_array 相同。这样各内核的签名（step_fn）保持不变。
+ * 只有调用内核的线程能看到当前工作区；并行区域中由工作线程分配的临时数组照旧走 huge_array。
+ * 同一个 Workspace 同一时间只能被一次调用使用，不同线程同时调用时各用各的 Workspace（否则抛出 std::logic_error）。
+ * 借出的内存内容未定义（可能是上一次调用留下的数据），内核必须在读之前写入，与 huge_array 的约定相同。
+ */
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "hugepage.h"
+
+class Workspace {
+public:
+    Workspace() = default;
+
+    // 预先分配 bytes 字节
+    explicit Workspace(const size_t bytes) {
+        if (bytes)
+            grow(bytes);
+    }
+
+    Workspace(const Workspace &) = delete;
+    Workspace &operator=(const Workspace &) = delete;
+
+    ~Workspace() {
+        release();
+    }
+
+    // 借出 bytes 字节（64 字节对齐），在下一次 reset 之前有效；内存不足时抛出 std::bad_alloc
+    void *take(size_t bytes) {
+        bytes = (bytes + 63) / 64 * 64;
+        if (blocks.empty() || blocks.back().bytes - used < bytes)
+            grow(bytes);
+        void *p = static_cast<char *>(blocks.back().p) + used;
+        used += bytes;
+        round_bytes += bytes;
+        peak = std::max(peak, round_bytes);
+        return p;
+    }
+
+    // 作废所有借出的内存；上一轮跨了多个块时合并成一个至少 peak_bytes() 大的块
+    void reset() {
+        if (blocks.size() > 1) {
+            release();
+            grow(peak);
+        }
+        used = 0;
+        round_bytes = 0;
+    }
+
+    // 当前持有的总字节数
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block &b: blocks)
+            total += b.bytes;
+        return total;
+    }
+
+    // 单次调用中借出的最大字节数
+    size_t peak_bytes() const {
+        return peak;
+    }
+
+    // 累计向系统分配的次数：同样大小的调用重复进行时应保持不变
+    size_t allocations() const {
+        return allocs;
+    }
+
+private:
+    friend class WorkspaceScope;
+
+    struct Block {
+        void *p;
+        size_t bytes;
+    };
+
+    void grow(const size_t bytes) {
+        size_t size = std::max(bytes, capacity());
+        if (size >= huge_page_size)
+            size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+        void *p = huge_alloc(size);
+        if (!p)
+            throw std::bad_alloc();
+        blocks.push_back(Block{p, size});
+        used = 0;
+        ++allocs;
+    }
+
+    void release() {
+        for (const Block &b: blocks)
+            huge_free(b.p);
+        blocks.clear();
+        used = 0;
+    }
+
+    std::vector<Block> blocks;
+    size_t used = 0;        // 最后一个块中已借出的字节数
+    size_t round_bytes = 0; // 本轮借出的总字节数
+    size_t peak = 0;
+    size_t allocs = 0;
+    std::atomic<bool> in_use{false};
+};
+
+// 当前线程的工作区，为空表示内核自行分配
+inline Workspace *&current_workspace() {
+    thread_local Workspace *ws = nullptr;
+    return ws;
+}
+
+/* 在作用域内把 ws 设为当前线程的工作区（ws 为空时即不使用工作区），开始时 reset，离开时恢复原来的工作区
+ *     Workspace ws;                      // 在多次调用之间保留
+ *     for (...) {
+ *         WorkspaceScope scope(&ws);
+ *         kernel(r, d, n, ld);
+ *     }
+ */
+class WorkspaceScope {
+public:
+    explicit WorkspaceScope(Workspace *ws) : ws(ws), saved(current_workspace()) {
+        if (ws) {
+            if (ws->in_use.exchange(true))
+                throw std::logic_error("workspace is already in use by another call");
+            ws->reset();
+        }
+        current_workspace() = ws;
+    }
+
+    WorkspaceScope(const WorkspaceScope &) = delete;
+    WorkspaceScope &operator=(const WorkspaceScope &) = delete;
+
+    ~WorkspaceScope() {
+        current_workspace() = saved;
+        if (ws)
+            ws->in_use = false;
+    }
+
+private:
+    Workspace *ws;
+    Workspace *saved;
+};
+
+namespace workspace_detail {
+    // 从工作区借来的内存由工作区统一回收，unique_ptr 的删除器什么也不做
+    inline void no_free(void *) {}
+}
+
+/* 内核中的临时数组：有当前工作区时从中借用，否则同 huge_array
+ * 返回类型与 huge_array 相同（huge_ptr<T>），可以直接替换；与 Workspace::grow 一致，分配失败时抛出 std::bad_alloc
+ */
+template <typename T>
+inline huge_ptr<T> scratch_array(const size_t count) {
+    if (Workspace *ws = current_workspace())
+        return huge_ptr<T>(static_cast<T *>(ws->take(count * sizeof(T))), workspace_detail::no_free);
+    huge_ptr<T> p = huge_array<T>(count);
+    if (count && !p)
+        throw std::bad_alloc();
+    return p;
+}
+
+#endif //WORKSPACE_H